@@ -1,15 +1,250 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+
+// Forward declarations
+class Bus;
+class CPU;
+class StateWriter;
+class StateReader;
+
+// 2A03 sound: two pulse channels, triangle, noise and DMC plus the frame
+// counter that clocks their envelopes, sweeps and length counters.
+// the mixer output goes through band-limited step synthesis: every change in
+// the output level is spread over a few samples with a windowed sinc, so
+// square waves don't alias no matter how high they go. everything lives in
+// fixed arrays, a frame of audio never allocates
 
 class APU {
+private:
+	// CONSTANTS
+
+	static const int CPU_CLOCK = 1789773; // NTSC
+
+	inline static const uint8_t LENGTH_TABLE[32] = {
+		10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+		12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+	};
+
+	inline static const uint8_t DUTY_TABLE[4][8] = {
+		{0, 1, 0, 0, 0, 0, 0, 0}, // 12.5%
+		{0, 1, 1, 0, 0, 0, 0, 0}, // 25%
+		{0, 1, 1, 1, 1, 0, 0, 0}, // 50%
+		{1, 0, 0, 1, 1, 1, 1, 1}, // 25% negated
+	};
+
+	inline static const uint8_t TRIANGLE_TABLE[32] = {
+		15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+	};
+
+	// noise and dmc periods are in cpu cycles
+	inline static const uint16_t NOISE_TABLE[16] = {
+		4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068,
+	};
+
+	inline static const uint16_t DMC_TABLE[16] = {
+		428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54,
+	};
+
+	// frame counter steps in cpu cycles
+	static const int FRAME_STEP_1 = 7457;
+	static const int FRAME_STEP_2 = 14913;
+	static const int FRAME_STEP_3 = 22371;
+	static const int FRAME_STEP_4 = 29829;
+	static const int FRAME_STEP_5 = 37281;
+
+	// band-limited synthesis
+	static const int PHASE_BITS = 6;
+	static const int PHASES = 1 << PHASE_BITS;
+	static const int KERNEL_WIDTH = 16;
+	// room for a few frames at 96kHz in case a frame runs long
+	static const int SAMPLE_CAPACITY = 8192;
+
+	// CHANNELS
+
+	struct Envelope {
+		bool start = false;
+		bool loop = false; // also halts the length counter
+		bool constant = false;
+		uint8_t volume = 0;
+		uint8_t divider = 0;
+		uint8_t decay = 0;
+	};
+
+	struct Pulse {
+		bool enabled = false;
+		uint8_t duty = 0;
+		uint8_t sequence = 0;
+		uint16_t period = 0;
+		uint16_t timer = 0;
+		uint8_t length = 0;
+		Envelope envelope;
+
+		bool sweepEnabled = false;
+		bool sweepNegate = false;
+		bool sweepReload = false;
+		uint8_t sweepPeriod = 0;
+		uint8_t sweepShift = 0;
+		uint8_t sweepDivider = 0;
+	};
+
+	struct Triangle {
+		bool enabled = false;
+		bool control = false; // also halts the length counter
+		bool linearReloadFlag = false;
+		uint8_t linearReload = 0;
+		uint8_t linearCounter = 0;
+		uint8_t sequence = 0;
+		uint16_t period = 0;
+		uint16_t timer = 0;
+		uint8_t length = 0;
+	};
+
+	struct Noise {
+		bool enabled = false;
+		bool mode = false;
+		uint16_t period = NOISE_TABLE[0];
+		uint16_t timer = 0;
+		uint16_t shift = 1;
+		uint8_t length = 0;
+		Envelope envelope;
+	};
+
+	struct DMC {
+		bool irqEnabled = false;
+		bool loop = false;
+		uint16_t period = DMC_TABLE[0];
+		uint16_t timer = 0;
+		uint8_t output = 0;
+
+		uint16_t sampleAddr = 0xC000;
+		uint16_t sampleLength = 1;
+		uint16_t currentAddr = 0xC000;
+		uint16_t bytesRemaining = 0;
+
+		uint8_t sampleBuffer = 0;
+		bool bufferEmpty = true;
+		uint8_t shift = 0;
+		uint8_t bitsRemaining = 8;
+		bool silence = true;
+	};
+
+	Pulse pulse1;
+	Pulse pulse2;
+	Triangle triangle;
+	Noise noise;
+	DMC dmc;
+
+	// FRAME COUNTER
+
+	int frameCycle = 0;
+	bool fiveStep = false;
+	bool irqInhibit = false;
+	bool frameIRQ = false;
+	bool dmcIRQ = false;
+	bool oddCycle = false; // pulse timers run at half the cpu clock
+
+	// cycles handed over by the bus but not run yet
+	int pendingCycles = 0;
+	int cyclesToEvent = 0;
+
+	// OUTPUT
+
+	int sampleRate = 44100;
+	uint64_t cycleFactor;   // samples per cpu cycle, 32.32 fixed point
+	uint64_t nextCycleFactor; // takes over at the next endFrame
+	uint64_t timeOffset = 0; // fraction of a sample carried over from the last frame
+	int frameTime = 0;      // cpu cycles since the last endFrame
+	float lastLevel = 0;
+
+	float deltas[SAMPLE_CAPACITY + KERNEL_WIDTH];
+	int16_t samples[SAMPLE_CAPACITY];
+	size_t sampleCount = 0;
+	float integrator = 0;
+	float filterIn = 0;
+	float filterOut = 0;
+
+	Bus* bus = nullptr;
+	CPU* cpu = nullptr;
+
+	void catchUp();
+	void clockCycle();
+	int cyclesToFrameStep();
+	int cyclesToNextEvent();
+	void skipCycles(int cycles);
+	void mix();
+	void clockQuarterFrame();
+	void clockHalfFrame();
+
+	void clockEnvelope(Envelope& envelope);
+	void clockSweep(Pulse& pulse, bool onesComplement);
+	uint16_t sweepTarget(const Pulse& pulse, bool onesComplement);
+	void clockPulseTimer(Pulse& pulse);
+	void clockDMCOutput();
+	void fetchDMCSample();
+	void restartDMC();
+	void updateIRQ();
+
+	bool pulseOutputs(const Pulse& pulse, bool onesComplement);
+	bool triangleRuns();
+	bool dmcIdle();
+	uint8_t pulseOutput(const Pulse& pulse, bool onesComplement);
+	uint8_t triangleOutput();
+	uint8_t noiseOutput();
+
+	void addDelta(int time, float delta);
+
+	// the channel structs have padding, states write them field by field
+	static void saveEnvelope(StateWriter& state, const Envelope& envelope);
+	static void loadEnvelope(StateReader& state, Envelope& envelope);
+	static void saveChannel(StateWriter& state, const Pulse& pulse);
+	static void loadChannel(StateReader& state, Pulse& pulse);
+	static void saveChannel(StateWriter& state, const Triangle& tri);
+	static void loadChannel(StateReader& state, Triangle& tri);
+	static void saveChannel(StateWriter& state, const Noise& channel);
+	static void loadChannel(StateReader& state, Noise& channel);
+	static void saveChannel(StateWriter& state, const DMC& channel);
+	static void loadChannel(StateReader& state, DMC& channel);
+
 public:
 	APU();
 
 	void reset();
 
+	// cycles are master clock cycles like the rest of the bus
 	void step(int cycles);
 
-	std::vector<uint8_t> getAudioBuffer();
-};
\ No newline at end of file
+	// $4000-$4013, $4015 and $4017
+	void writeRegister(uint16_t addr, uint8_t value);
+	// $4015
+	uint8_t readStatus();
+
+	// master cycles until the next frame counter step and the next dmc
+	// sample fetch (-1 when no sample is playing). the irqs only come on
+	// these, the bus doesn't have to hand over cycles before then
+	int cyclesToFrameCounter();
+	int cyclesToDMCFetch();
+
+	// turn the cycles run since the last call into samples. the sample count
+	// follows the cpu cycles exactly, leftover fractions carry to the next frame
+	void endFrame();
+	const int16_t* getSamples() const;
+	size_t getSampleCount() const;
+
+	void setSampleRate(int rate);
+	int getSampleRate() const;
+	// stretch the output by a small ratio (1.0 = exact) so the host can keep
+	// its audio buffer level steady. applies from the next frame on
+	void setRateAdjust(double ratio);
+
+	// save states
+	void saveState(StateWriter& state);
+	void loadState(StateReader& state);
+
+	void connectBus(Bus* busRef);
+	void disconnectBus();
+	void connectCPU(CPU* cpuRef);
+	void disconnectCPU();
+};
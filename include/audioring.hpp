@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// single producer / single consumer sample ring.
+// the emulation thread writes, the SDL audio callback reads. each side only
+// stores its own index and loads the other one, so neither side ever takes a
+// lock or waits on the other. the buffer is sized once up front, pushing and
+// pulling samples never allocates
+
+class AudioRing {
+private:
+	std::vector<int16_t> buffer;
+	size_t mask = 0;
+
+	// free running counters, only the low bits index the buffer
+	alignas(64) std::atomic<size_t> readPos{0};
+	alignas(64) std::atomic<size_t> writePos{0};
+
+public:
+	AudioRing() {}
+
+	// capacity is rounded up to a power of two. not safe while the other
+	// side is running
+	void init(size_t capacity) {
+		size_t size = 1;
+		while (size < capacity) size <<= 1;
+		buffer.assign(size, 0);
+		mask = size - 1;
+		readPos.store(0, std::memory_order_relaxed);
+		writePos.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const {
+		return buffer.size();
+	}
+
+	// samples waiting to be read. exact from either side, the other side can
+	// only move it in its own direction
+	size_t fill() const {
+		return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire);
+	}
+
+	// producer side, returns how many samples fit
+	size_t write(const int16_t* samples, size_t count) {
+		size_t write = writePos.load(std::memory_order_relaxed);
+		size_t space = buffer.size() - (write - readPos.load(std::memory_order_acquire));
+		if (count > space) count = space;
+
+		size_t start = write & mask;
+		size_t first = count < buffer.size() - start ? count : buffer.size() - start;
+		memcpy(buffer.data() + start, samples, first * sizeof(int16_t));
+		memcpy(buffer.data(), samples + first, (count - first) * sizeof(int16_t));
+
+		writePos.store(write + count, std::memory_order_release);
+		return count;
+	}
+
+	// consumer side, returns how many samples were there
+	size_t read(int16_t* samples, size_t count) {
+		size_t read = readPos.load(std::memory_order_relaxed);
+		size_t available = writePos.load(std::memory_order_acquire) - read;
+		if (count > available) count = available;
+
+		size_t start = read & mask;
+		size_t first = count < buffer.size() - start ? count : buffer.size() - start;
+		memcpy(samples, buffer.data() + start, first * sizeof(int16_t));
+		memcpy(samples + first, buffer.data(), (count - first) * sizeof(int16_t));
+
+		readPos.store(read + count, std::memory_order_release);
+		return count;
+	}
+
+	// consumer side, throws away everything queued
+	void clear() {
+		readPos.store(writePos.load(std::memory_order_acquire), std::memory_order_release);
+	}
+};
@@ -1,36 +1,115 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
+#include <vector>
+
+#include "scheduler.hpp"
 
 // Forward declarations
 class APU;
 class PPU;
 class Cart;
 class Controller;
+class StateWriter;
+class StateReader;
+
+struct Cheat {
+	uint16_t addr;
+	uint8_t value;
+	int compare = -1; // -1 always patches, otherwise only when the real byte matches
+};
 
 
 class Bus {
 private:
 	uint8_t memory [0x800]; // 2KB internal memory
 
+	// cpu address space split into 64 pages of 1KB.
+	// a non-null entry points straight at the backing memory for that page,
+	// a null entry falls back to the register handlers in readSlow/writeSlow
+	static const int PAGE_SHIFT = 10;
+	static const int PAGE_SIZE = 1 << PAGE_SHIFT;
+	static const int PAGE_COUNT = 0x10000 >> PAGE_SHIFT;
+
+	uint8_t* readPages[PAGE_COUNT];
+	uint8_t* writePages[PAGE_COUNT];
+
+	// what is actually mapped, readPages hides pages that have cheats on them
+	uint8_t* mappedPages[PAGE_COUNT];
+	uint8_t cheatsOnPage[PAGE_COUNT];
+	std::vector<Cheat> cheats;
+
 	APU* apu = nullptr;
 	PPU* ppu = nullptr;
 	Cart* cart = nullptr;
 	Controller* controller1 = nullptr;
 	Controller* controller2 = nullptr;
-public:
 
-	std::map<uint16_t, uint8_t> cheats;
+	// the ppu and apu run behind the cpu. cycles pile up here and are only
+	// handed over when the cpu touches their registers or the mapper, or
+	// when the next scheduled event is due
+	static const int FRAME_CYCLES = 341 * 262 * PPU_CLOCK_DIVIDER; // master cycles
+	Scheduler scheduler;
+	uint64_t masterClock = 0; // master cycles up to the last sync
+	int pendingCycles = 0;    // master cycles since then
+	int syncDeadline = 0;     // master cycles from the last sync to the next event
+	bool frameDone = false;   // a sync in the middle of an instruction ended the frame
 
+	bool syncSlow();
+	void updateDeadline();
+	void schedulePPU();
+	void scheduleAPU();
+	void scheduleMapper();
+	void resetEvents();
+
+	uint8_t readSlow(uint16_t addr);
+	uint8_t readUnpatched(uint16_t addr);
+	void writeSlow(uint16_t addr, uint8_t val);
+	void updateCheatPage(int page);
+
+public:
 	Bus();
 
 	void clearMem();
 
-	uint8_t read(uint16_t addr);
-	void write(uint16_t addr, uint8_t val);
+	// fast path is inlined so ram and prg fetches are a single indexed load
+	uint8_t read(uint16_t addr) {
+		uint8_t* page = readPages[addr >> PAGE_SHIFT];
+		if (page) return page[addr & (PAGE_SIZE - 1)];
+		return readSlow(addr);
+	}
+
+	void write(uint16_t addr, uint8_t val) {
+		uint8_t* page = writePages[addr >> PAGE_SHIFT];
+		if (page) page[addr & (PAGE_SIZE - 1)] = val;
+		else writeSlow(addr, val);
+	}
+
+	// page table management, used by mappers when they switch banks
+	// addr and size must be multiples of 1KB
+	void mapPages(uint16_t addr, uint32_t size, uint8_t* data, bool writable);
+	void unmapPages(uint16_t addr, uint32_t size);
+
+	// cheats only take the affected pages off the fast path
+	void addCheat(uint16_t addr, uint8_t value, int compare = -1);
+	bool removeCheat(uint16_t addr);
+	void clearCheats();
+	const std::vector<Cheat>& getCheats() const;
+
+	// master clock cycles, returns true once the frame is done
+	bool clock(int cycles) {
+		pendingCycles += cycles;
+		if (pendingCycles < syncDeadline) return false;
+		return syncSlow();
+	}
+	// bring the ppu and apu up to the cpu
+	void sync();
+	// where the ppu is right now, for traces
+	void getPPUPosition(int& scanline, int& dot);
 
-	bool clock(int cycles);
+	// save states only cover ram, cheats belong to the user not the game
+	void saveState(StateWriter& state);
+	void loadState(StateReader& state);
 
 	void connectAPU(APU* apu);
 	void disconnectAPU();
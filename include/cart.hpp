@@ -2,16 +2,24 @@
 
 #include <cstdint>
 #include <vector>
-#include <array>
 #include <fstream>
 #include <string>
 
-#include "mappers/mapper.hpp"
+#include "headerdb.hpp"
+#include "mappedfile.hpp"
+
+class Bus;
+class CPU;
+class Mapper;
+class StateWriter;
+class StateReader;
 
 enum MirroringType {
 	HORIZONTAL = 0,
 	VERTICAL = 1,
-	FOUR_SCREEN = 2
+	FOUR_SCREEN = 2,
+	ONE_SCREEN_LOW = 3,
+	ONE_SCREEN_HIGH = 4
 };
 
 class Cart {
@@ -28,18 +36,28 @@ public:
 
 	std::string filename;
 
-	std::vector<std::array<uint8_t, 0x4000>> prgBanks;
-	std::vector<std::array<uint8_t, 0x2000>> chrBanks;
-	
+	// prg and chr each live in one contiguous buffer, mappers point their
+	// bank slots into them. rom comes straight from the file mapping, chr
+	// is 8KB of chr ram (nes 2.0: the size in the header) when the file
+	// has no chr rom
+	uint8_t* prg = nullptr;
+	uint8_t* chr = nullptr;
+	uint32_t prgSize = 0;
+	uint32_t chrSize = 0;
+	bool chrRam = false;
+
 	Mapper* mapper = nullptr;
 
 	uint8_t header[16];
 	int romBankCount = 0;
-	int romSize = 0;
 	int chrBankCount = 0;
-	int chrSize = 0;
 
 	int mapperID = 0;
+	int submapperID = 0;
+
+	// crc32 of prg+chr as stored in the file, the header database key
+	uint32_t crc = 0;
+	bool headerFixed = false; // the database corrected the header
 
 	bool fourScreen = false;
 	bool hasTrainer = false;
@@ -53,15 +71,67 @@ public:
 	int trainerSize = 0;
 	
 	Cart();
-	Cart(std::string fName);
+	~Cart();
+
+	Cart(const Cart&) = delete;
+	Cart& operator=(const Cart&) = delete;
+
+	// database is optional, without it the header is taken as it is
+	Cart(std::string fName, const HeaderDatabase* database = nullptr);
 
 	uint8_t read(uint16_t addr);
 	void write(uint16_t addr, uint8_t val);
-	uint8_t readChr(uint16_t addr);
 	void writeChr(uint16_t addr, uint8_t val);
 
-	int mirrorNametable(int ntIdx);
+	// the ppu's fetches, inlined. they read the chr slots and nametable map
+	// the mapper keeps up to date instead of calling into it
+	uint8_t readChr(uint16_t addr) {
+		if (chrSlots) return chrSlots[(addr >> 10) & 7][addr & 0x3FF];
+		return readChrSlow(addr);
+	}
+	int mirrorNametable(int ntIdx) {
+		if (nametables) return nametables[ntIdx];
+		return mirrorNametableSlow(ntIdx);
+	}
+	// off sends every fetch through the mapper's virtual calls, for
+	// benchmarking the difference
+	void setDirectAccess(bool enabled);
+
+	// per 1KB chr page change counters, null without a mapper
+	const uint32_t* getChrVersions();
+
+	// scanline irq counters (mmc3). the ppu clocks the counter once per
+	// rendered line, the bus asks how many clocks are left until the irq to
+	// schedule it, -1 when none is coming
+	void clockScanline();
+	int scanlinesToIRQ();
+
+	// mapper registers plus chr ram, chr rom never changes so it is skipped
+	void saveState(StateWriter& state);
+	void loadState(StateReader& state);
+
+	void connectBus(Bus* bus);
+	void disconnectBus();
+	void connectCPU(CPU* cpu);
+	void disconnectCPU();
 
 private:
+	// null without a mapper (or with direct access off)
+	uint8_t* const* chrSlots = nullptr;
+	const uint8_t* nametables = nullptr;
+
+	uint8_t readChrSlow(uint16_t addr);
+	int mirrorNametableSlow(int ntIdx);
+
+	static const uint64_t MAX_ROM_SIZE = 64 << 20;
+
+	MappedFile file;
+
+	// chr ram, or both buffers when the file can't be used directly.
+	// starts on a page boundary
+	static const uintptr_t STORAGE_ALIGN = 4096;
+	std::vector<uint8_t> storage;
+	uint8_t* allocate(size_t size);
+
 	void pickMapper(int mapperID);
 };
\ No newline at end of file
@@ -15,16 +15,29 @@ private:
 
 	uint32_t frameBuffer[256 * 240]; // NES resolution
 
+	// one scanline as palette ram indices, 0 is transparent. the background
+	// line comes from the ppu, sprites use 0x10-0x1F so both fit the same
+	// 32 entry color table
+	uint8_t spriteLine[256];
+	uint8_t behindLine[256]; // 0xFF where the sprite pixel goes behind the background
+	uint8_t mergedLine[256];
+
 public:
 	Composite();
 
 	
 
-	void renderScanline(int scanline);
+	// returns true when sprite 0 hit the background on this line
+	bool renderScanline(int scanline);
+
+	void renderSpritesAtLine(uint8_t* lineBuf, uint8_t* behindBuf);
+	bool sprite0Hit();
 
-	void renderBackgroundAtLine(int scanline, uint32_t* lineBuf);
-	void renderNametableAtLine(int scanline, int nametableIdx, int xPos, int yPos, uint32_t* lineBuf);
-	void renderSpritesAtLine(int scanline, int spriteIdx, uint32_t* lineBuf);
+	// priority merge of a background and a sprite line into palette indices.
+	// the simd version uses avx2 or sse2 when the compiler targets them and
+	// falls back to the scalar one otherwise
+	static void mergeLine(const uint8_t* bg, const uint8_t* sprite, const uint8_t* behind, uint8_t* out);
+	static void mergeLineScalar(const uint8_t* bg, const uint8_t* sprite, const uint8_t* behind, uint8_t* out);
 
 	uint32_t* getBuffer();
 
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "apu.hpp"
+#include "bus.hpp"
+#include "cart.hpp"
+#include "composite.hpp"
+#include "controller.hpp"
+#include "cpu.hpp"
+#include "ppu.hpp"
+#include "savestate.hpp"
+
+
+// the console wires the emulated hardware together without any frontend.
+// Core adds the SDL window and keyboard handling on top of it, the headless
+// runner drives it directly
+
+
+class Console {
+public:
+	Bus bus;
+	CPU cpu;
+	PPU ppu;
+	Composite comp;
+	APU apu;
+	Controller controller1;
+	Controller controller2;
+
+	Cart* cart = nullptr;
+
+	Console();
+
+	// a console with cart and a standard controller connected, reset and
+	// ready to step. it's too big for the stack (frame buffer)
+	static std::unique_ptr<Console> create(Cart* cart);
+
+	void reset();
+	void powerOn();
+	void fullReset();
+
+	// run the cpu until the ppu finishes the current frame. a breakpoint
+	// stops it early, the rest of the frame runs on the next call
+	CPU::RunResult stepFrame();
+
+	// save states go into a buffer the caller owns, so taking one every frame
+	// never touches the heap. stateSize is fixed for a given cart and
+	// controller setup, size buffers with it once.
+	// saveState returns the bytes written or 0 if the buffer is too small,
+	// loadState leaves the console untouched if the state doesn't fit it.
+	// the frame buffer is not part of the state, it is redrawn next frame
+	size_t stateSize();
+	size_t saveState(uint8_t* data, size_t capacity);
+	bool loadState(const uint8_t* data, size_t size);
+
+	// fnv1a of the frame buffer, what regression runs compare frames by
+	uint64_t frameHash();
+
+	void connectCart(Cart* cart);
+	void disconnectCart();
+	void setController1(ControllerType type);
+	void setController2(ControllerType type);
+
+private:
+	void writeState(StateWriter& state);
+};
+
+// 64 bit fnv-1a, for frame and ram hashes
+uint64_t fnv1a(const uint8_t* data, size_t size);
@@ -52,4 +52,15 @@ public:
 	void setState(uint8_t buttonMask) {
 		stateHandler->setState(buttonMask);
 	}
+	// the controller type is not saved, load into a console set up the same way
+	void saveState(StateWriter& state) {
+		if (stateHandler) {
+			stateHandler->saveState(state);
+		}
+	}
+	void loadState(StateReader& state) {
+		if (stateHandler) {
+			stateHandler->loadState(state);
+		}
+	}
 };
\ No newline at end of file
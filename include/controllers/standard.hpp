@@ -25,7 +25,7 @@ private:
 	int readIndex = 1;
 public:
 	StandardStateHandler() {
-
+		state.raw = 0;
 	}
 
 	void write(uint8_t value) {
@@ -59,4 +59,16 @@ public:
 	void setState(uint8_t buttonMask) {
 		state.raw = buttonMask;
 	}
+
+	void saveState(StateWriter& writer) {
+		writer.write(state.raw);
+		writer.write(strobe);
+		writer.write(readIndex);
+	}
+
+	void loadState(StateReader& reader) {
+		reader.read(state.raw);
+		reader.read(strobe);
+		reader.read(readIndex);
+	}
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <cstdint>
 
+#include "savestate.hpp"
+
 
 
 class ControllerStateHandler {
@@ -10,4 +12,6 @@ public:
 	virtual uint8_t read() = 0;
 	virtual void setButtonState(uint8_t buttonMask, bool pressed) = 0;
 	virtual void setState(uint8_t buttonMask) = 0;
+	virtual void saveState(StateWriter& state) = 0;
+	virtual void loadState(StateReader& state) = 0;
 };
\ No newline at end of file
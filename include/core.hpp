@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -8,35 +9,19 @@
 
 #include <SDL2/SDL.h>
 
-#include "apu.hpp"
-#include "bus.hpp"
-#include "cart.hpp"
-#include "composite.hpp"
-#include "controller.hpp"
-#include "cpu.hpp"
+#include "console.hpp"
 #include "palettes.hpp"
-#include "ppu.hpp"
+#include "rewind.hpp"
 #include "window.hpp"
 #include "ui/message.hpp"
 
 
-// the core initializes and manages all the components
+// the core runs a console behind the SDL window and handles user input
 
 
-class Core {
+class Core : public Console {
 public:
-	Bus bus;
-	CPU cpu;
-	PPU ppu;
-	Composite comp;
-	APU apu;
 	Window window;
-	Controller controller1;
-	Controller controller2;
-
-	Cart* cart = nullptr;
-
-	bool enableWindow = true;
 
 	// time management
 	double emulationSpeed = 1.0; // 1.0 = normal speed
@@ -44,6 +29,33 @@ public:
 	bool paused = false;
 	bool passFrame = false; // used when paused to advance a single frame
 
+	// how far ahead of the sound card audio is queued, in ms
+	int audioLatency = 30;
+
+	// TIMER just presents frames at the ntsc rate. AUDIO lets the audio
+	// queue steer both: the apu output is stretched by up to MAX_RATE_ADJUST
+	// and each frame is held back or brought forward by a share of the
+	// queue's distance from the target (at most MAX_FRAME_SHIFT_MS), so the
+	// sound card's clock and the timer can't drift apart
+	enum class Pacing {
+		TIMER,
+		AUDIO
+	};
+	Pacing pacing = Pacing::AUDIO;
+	static constexpr double MAX_RATE_ADJUST = 0.005;
+	static constexpr double FRAME_SHIFT_GAIN = 0.1;
+	static constexpr double MAX_FRAME_SHIFT_MS = 1.0;
+	void updateRateControl();
+
+	// header corrections from headerdb.txt (if there is one), used for
+	// every rom loaded through the core
+	HeaderDatabase headerDatabase;
+
+	// rewind history, recorded every frame and played back while backspace is held
+	Rewind rewind;
+	bool enableRewind = true;
+	bool rewinding = false;
+
 	// messaging system
 	std::vector<Message> messages;
 	void addMessage(const std::string& text, uint32_t textColor, int timeToLive = 5000);
@@ -67,9 +79,17 @@ public:
 	void commandSlowDown(double factor);
 	void commandSetSpeed(double speed);
 	void commandLoadROM(std::string filename);
+	void commandSaveState();
+	void commandLoadState();
+	void commandAudioStats();
+	void commandSetPacing(std::string mode);
 	uint8_t gGCharToHex(char c);
 	void addGameGenieCheat(std::string cheatCode);
-	void addCheat(uint16_t addr, uint8_t val);
+	void addCheat(uint16_t addr, uint8_t val, int compare = -1);
+
+	// quick save slot, kept between saves so it is only allocated once
+	std::vector<uint8_t> quickState;
+	size_t quickStateSize = 0;
 
 	int lastKeyScancode = -1;
 	bool rebindInProgress = false;
@@ -103,19 +123,13 @@ public:
 	Core();
 
 	void run();
-	void reset();
-	void powerOn();
-	void fullReset();
 
 	void handleWindowEvents();
 	void handleKeyboardEvent(SDL_KeyboardEvent keyEvent);
 	uint8_t getControllerButtonState() const;
 	void processHeldKeys();
 
-	void connectCart(Cart* cart);
-	void disconnectCart();
-	void setController1(ControllerType type);
-	void setController2(ControllerType type);
+	void connectCart(Cart* cart); // also reports the load status
 
 	// tieg
 	void randomizeMemory(int numBytes);
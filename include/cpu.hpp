@@ -2,9 +2,14 @@
 
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 
-// Forward declaration
+// Forward declarations
 class Bus;
+class StateWriter;
+class StateReader;
+class TraceRecorder;
 
 union StatusRegister {
 	struct {
@@ -137,12 +142,26 @@ private:
 	// STATE
 	
 	long int cycles;
-	bool enableCpuLog = false;
+	uint64_t instructionCount = 0; // statistics only, not part of save states
+	TraceRecorder* trace = nullptr;
 	
 	bool pageCrossed;
+
+	uint8_t irqLine = 0; // one bit per device holding the irq line low
+	bool nmiPending = false;
+
+	// pcs to stop at, checked before the instruction there runs
+	std::vector<uint16_t> breakpoints;
+	bool breakpointHit = false;
 	
 public:
 
+	// irq sources, the line stays asserted until every source lets go
+	enum IRQSource : uint8_t {
+		IRQ_APU = 1 << 0,
+		IRQ_MAPPER = 1 << 1,
+	};
+
 	bool jammed = false;
 	
 	CPU();
@@ -168,17 +187,27 @@ public:
 	bool isJammed();
 	void setJammed(bool jammed);
 	long int getCycles();
-	void enableLogging(bool enable);
+	uint64_t getInstructionCount();
+	uint16_t getPC();
+	void setPC(uint16_t addr);
+	// every instruction goes to the recorder before it runs, null stops it
+	void setTrace(TraceRecorder* recorder);
+	static const char* getMnemonic(uint8_t opcode);
 	
 	void connectBus(Bus* busRef);
 	void disconnectBus();
 
+	// save states
+	void saveState(StateWriter& state);
+	void loadState(StateReader& state);
+
 private:
 
 
 	// helpers
 
-	uint16_t getOperandAddress(AddressingMode mode);
+	// resolved at compile time for each (operation, addressing mode) pair
+	template<AddressingMode mode> uint16_t getOperandAddress();
 
 	// specific helpers
 
@@ -200,88 +229,88 @@ private:
 
 	// OFFICIAL OPCODES
 
-	void op_ADC(AddressingMode mode);
-	void op_AND(AddressingMode mode);
-	void op_ASL(AddressingMode mode);
-	void op_BCC(AddressingMode mode);
-	void op_BCS(AddressingMode mode);
-	void op_BEQ(AddressingMode mode);
-	void op_BIT(AddressingMode mode);
-	void op_BMI(AddressingMode mode);
-	void op_BNE(AddressingMode mode);
-	void op_BPL(AddressingMode mode);
-	void op_BRK(AddressingMode mode);
-	void op_BVC(AddressingMode mode);
-	void op_BVS(AddressingMode mode);
-	void op_CLC(AddressingMode mode);
-	void op_CLD(AddressingMode mode);
-	void op_CLI(AddressingMode mode);
-	void op_CLV(AddressingMode mode);
-	void op_CMP(AddressingMode mode);
-	void op_CPX(AddressingMode mode);
-	void op_CPY(AddressingMode mode);
-	void op_DEC(AddressingMode mode);
-	void op_DEX(AddressingMode mode);
-	void op_DEY(AddressingMode mode);
-	void op_EOR(AddressingMode mode);
-	void op_INC(AddressingMode mode);
-	void op_INX(AddressingMode mode);
-	void op_INY(AddressingMode mode);
-	void op_JMP(AddressingMode mode);
-	void op_JSR(AddressingMode mode);
-	void op_LDA(AddressingMode mode);
-	void op_LDX(AddressingMode mode);
-	void op_LDY(AddressingMode mode);
-	void op_LSR(AddressingMode mode);
-	void op_NOP(AddressingMode mode);
-	void op_ORA(AddressingMode mode);
-	void op_PHA(AddressingMode mode);
-	void op_PHP(AddressingMode mode);
-	void op_PLA(AddressingMode mode);
-	void op_PLP(AddressingMode mode);
-	void op_ROL(AddressingMode mode);
-	void op_ROR(AddressingMode mode);
-	void op_RTI(AddressingMode mode);
-	void op_RTS(AddressingMode mode);
-	void op_SBC(AddressingMode mode);
-	void op_SEC(AddressingMode mode);
-	void op_SED(AddressingMode mode);
-	void op_SEI(AddressingMode mode);
-	void op_STA(AddressingMode mode);
-	void op_STX(AddressingMode mode);
-	void op_STY(AddressingMode mode);
-	void op_TAX(AddressingMode mode);
-	void op_TAY(AddressingMode mode);
-	void op_TSX(AddressingMode mode);
-	void op_TXA(AddressingMode mode);
-	void op_TXS(AddressingMode mode);
-	void op_TYA(AddressingMode mode);
+	template<AddressingMode mode> void op_ADC();
+	template<AddressingMode mode> void op_AND();
+	template<AddressingMode mode> void op_ASL();
+	template<AddressingMode mode> void op_BCC();
+	template<AddressingMode mode> void op_BCS();
+	template<AddressingMode mode> void op_BEQ();
+	template<AddressingMode mode> void op_BIT();
+	template<AddressingMode mode> void op_BMI();
+	template<AddressingMode mode> void op_BNE();
+	template<AddressingMode mode> void op_BPL();
+	template<AddressingMode mode> void op_BRK();
+	template<AddressingMode mode> void op_BVC();
+	template<AddressingMode mode> void op_BVS();
+	template<AddressingMode mode> void op_CLC();
+	template<AddressingMode mode> void op_CLD();
+	template<AddressingMode mode> void op_CLI();
+	template<AddressingMode mode> void op_CLV();
+	template<AddressingMode mode> void op_CMP();
+	template<AddressingMode mode> void op_CPX();
+	template<AddressingMode mode> void op_CPY();
+	template<AddressingMode mode> void op_DEC();
+	template<AddressingMode mode> void op_DEX();
+	template<AddressingMode mode> void op_DEY();
+	template<AddressingMode mode> void op_EOR();
+	template<AddressingMode mode> void op_INC();
+	template<AddressingMode mode> void op_INX();
+	template<AddressingMode mode> void op_INY();
+	template<AddressingMode mode> void op_JMP();
+	template<AddressingMode mode> void op_JSR();
+	template<AddressingMode mode> void op_LDA();
+	template<AddressingMode mode> void op_LDX();
+	template<AddressingMode mode> void op_LDY();
+	template<AddressingMode mode> void op_LSR();
+	template<AddressingMode mode> void op_NOP();
+	template<AddressingMode mode> void op_ORA();
+	template<AddressingMode mode> void op_PHA();
+	template<AddressingMode mode> void op_PHP();
+	template<AddressingMode mode> void op_PLA();
+	template<AddressingMode mode> void op_PLP();
+	template<AddressingMode mode> void op_ROL();
+	template<AddressingMode mode> void op_ROR();
+	template<AddressingMode mode> void op_RTI();
+	template<AddressingMode mode> void op_RTS();
+	template<AddressingMode mode> void op_SBC();
+	template<AddressingMode mode> void op_SEC();
+	template<AddressingMode mode> void op_SED();
+	template<AddressingMode mode> void op_SEI();
+	template<AddressingMode mode> void op_STA();
+	template<AddressingMode mode> void op_STX();
+	template<AddressingMode mode> void op_STY();
+	template<AddressingMode mode> void op_TAX();
+	template<AddressingMode mode> void op_TAY();
+	template<AddressingMode mode> void op_TSX();
+	template<AddressingMode mode> void op_TXA();
+	template<AddressingMode mode> void op_TXS();
+	template<AddressingMode mode> void op_TYA();
 
 	// UNOFFICIAL OPCODES
 	// names following https://www.masswerk.at/6502/6502_instruction_set.html
 
-	void op_ALR(AddressingMode mode);
-	void op_ANC(AddressingMode mode);
-	void op_ANC2(AddressingMode mode);
-	void op_ANE(AddressingMode mode);
-	void op_ARR(AddressingMode mode);
-	void op_DCP(AddressingMode mode);
-	void op_ISC(AddressingMode mode);
-	void op_LAS(AddressingMode mode);
-	void op_LAX(AddressingMode mode);
-	void op_LXA(AddressingMode mode);
-	void op_RLA(AddressingMode mode);
-	void op_RRA(AddressingMode mode);
-	void op_SAX(AddressingMode mode);
-	void op_SBX(AddressingMode mode);
-	void op_SHA(AddressingMode mode);
-	void op_SHX(AddressingMode mode);
-	void op_SHY(AddressingMode mode);
-	void op_SLO(AddressingMode mode);
-	void op_SRE(AddressingMode mode);
-	void op_TAS(AddressingMode mode);
-	void op_USBC(AddressingMode mode);
-	void op_JAM(AddressingMode mode);
+	template<AddressingMode mode> void op_ALR();
+	template<AddressingMode mode> void op_ANC();
+	template<AddressingMode mode> void op_ANC2();
+	template<AddressingMode mode> void op_ANE();
+	template<AddressingMode mode> void op_ARR();
+	template<AddressingMode mode> void op_DCP();
+	template<AddressingMode mode> void op_ISC();
+	template<AddressingMode mode> void op_LAS();
+	template<AddressingMode mode> void op_LAX();
+	template<AddressingMode mode> void op_LXA();
+	template<AddressingMode mode> void op_RLA();
+	template<AddressingMode mode> void op_RRA();
+	template<AddressingMode mode> void op_SAX();
+	template<AddressingMode mode> void op_SBX();
+	template<AddressingMode mode> void op_SHA();
+	template<AddressingMode mode> void op_SHX();
+	template<AddressingMode mode> void op_SHY();
+	template<AddressingMode mode> void op_SLO();
+	template<AddressingMode mode> void op_SRE();
+	template<AddressingMode mode> void op_TAS();
+	template<AddressingMode mode> void op_USBC();
+	template<AddressingMode mode> void op_JAM();
 
 
 
@@ -292,16 +321,35 @@ public:
 
 	// RUNNING
 
-	void run();
-	bool clock(); // bool to pass nmi
+	enum RunResult {
+		RUN_BUDGET,     // the cycle budget is used up
+		RUN_FRAME,      // the ppu finished a frame
+		RUN_BREAKPOINT, // stopped in front of a breakpoint, pc points at it
+		RUN_JAMMED,     // a jam opcode halted the cpu
+	};
+
+	// runs instructions until at least cycleBudget cycles have passed or
+	// one of the other results comes up. interrupts are taken in between
+	// instructions as usual. running again after a breakpoint carries on
+	// with the instruction it stopped at
+	RunResult run(int64_t cycleBudget);
+	// one instruction (or interrupt), true once the frame is done or jammed
+	bool clock();
 	void runInstruction(uint8_t opcode);
 
+	void addBreakpoint(uint16_t addr);
+	bool removeBreakpoint(uint16_t addr);
+	void clearBreakpoints();
+	bool hasBreakpoint(uint16_t addr) const;
+	const std::vector<uint16_t>& getBreakpoints() const;
+
 	// External interrupt trigger (called by PPU when NMI occurs)
 	void triggerNMI();
+	// level triggered, taken before the next instruction while I is clear
+	void setIRQ(uint8_t source, bool active);
 
-	// Logging helper: write a single-line instruction trace to cpu.log when
-	// `enableCpuLog` is true. Format example:
-	// C000 4C F5 C5 a:00, x:00, y:00, p:24, sp:FD cyc:7
-	void logInstruction(uint16_t instrPc, uint8_t opcode, const uint8_t* opcodeBytes, size_t byteCount);
+private:
+	template<bool checked> RunResult runLoop(int64_t cycleBudget);
+	void traceNextInstruction();
 
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// corrections for roms whose header is wrong.
+// entries are keyed by the crc32 of prg+chr, the same key the common nes
+// header databases use, so a bad dump is recognized by its contents no
+// matter what its header says. the file is text, one rom per line:
+//
+//   # comment
+//   1a2b3c4d mapper=1 mirroring=vertical battery=1
+//
+// mirroring is horizontal, vertical or four. fields that aren't given keep
+// what the header says
+
+struct HeaderFix {
+	int mapper = -1;
+	int mirroring = -1; // MirroringType
+	int battery = -1;
+};
+
+class HeaderDatabase {
+private:
+	std::unordered_map<uint32_t, HeaderFix> entries;
+
+public:
+	// adds the entries in path to the ones already loaded. false when the
+	// file can't be read, lines that don't parse are skipped
+	bool load(const std::string& path);
+	void add(uint32_t crc, const HeaderFix& fix);
+	// null when the rom isn't listed
+	const HeaderFix* find(uint32_t crc) const;
+	size_t size() const;
+};
+
+// crc32 (the zip/png one), continue a running crc by passing it back in
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// read-only view of a whole file through the os page cache.
+// the mapping is copy on write, so the data can be handed out as plain
+// uint8_t* (rom banks, page tables) without the file ever being modified.
+// nothing is read until a page is touched
+
+class MappedFile {
+private:
+	uint8_t* view = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// false when the file can't be opened or is empty
+	bool open(const std::string& path);
+	void close();
+
+	uint8_t* data() const;
+	size_t size() const;
+};
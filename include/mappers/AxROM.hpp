@@ -1,7 +1,5 @@
 #pragma once
 
-#include <vector>
-#include <array>
 #include <cstdint>
 
 #include "mapper.hpp"
@@ -14,15 +12,12 @@ private:
 public:
 	AxROM(Cart* cartRef) {
 		cart = cartRef;
-		prgBankCount = cart->prgBanks.size();
-		chrBankCount = cart->chrBanks.size();
+		prgBankCount = cart->prgSize / 0x4000;
+		chrBankCount = cart->chrSize / 0x2000;
 		mapperID = 7;
 
-		// AxROM usually uses CHR-RAM. If the cart file didn't have CHR ROM,
-		// we need to allocate the 8KB RAM bank.
-		if (chrBankCount == 0) {
-			cart->chrBanks.push_back(std::array<uint8_t, 0x2000>{});
-		}
+		// AxROM usually uses CHR-RAM, the cart gives us 8KB of it then
+		selectChr(0x0000, 0x2000, 0);
 
 		reset();
 	}
@@ -30,32 +25,7 @@ public:
 	void reset() override {
 		prgBank = 0;
 		mirrorPage = 0;
-	}
-
-	uint8_t read(uint16_t addr) override {
-		if (addr >= 0x8000) {
-			// AxROM switches 32KB chunks.
-			// Since our vector holds 16KB chunks, we multiply the index by 2.
-			int baseBankIndex = (prgBank * 2);
-
-			// Safety modulo to handle ROMs smaller than the bank selection allows
-			// (Use bitmasking logic if strict hardware accuracy is required,
-			// but modulo is safer for emulators handling bad headers).
-			baseBankIndex %= prgBankCount;
-
-			if (addr < 0xC000) {
-				// Lower 16KB ($8000-$BFFF)
-				return cart->prgBanks[baseBankIndex][addr - 0x8000];
-			} else {
-				// Upper 16KB ($C000-$FFFF)
-				// We need the next 16KB chunk in the vector
-				// Check bounds in case we are at the very end of the vector
-				if (baseBankIndex + 1 < (int)cart->prgBanks.size()) {
-					return cart->prgBanks[baseBankIndex + 1][addr - 0xC000];
-				}
-			}
-		}
-		return 0;
+		updateBanks();
 	}
 
 	void write(uint16_t addr, uint8_t value) override {
@@ -65,28 +35,27 @@ public:
 
 			// Bit 4: Select Single Screen Mirroring Page (0 or 1)
 			mirrorPage = (value & 0x10) >> 4;
+
+			updateBanks();
 		}
 	}
 
-	uint8_t readChr(uint16_t addr) override {
-		// AxROM almost exclusively uses CHR-RAM (Bank 0)
-		if (addr < 0x2000) {
-			return cart->chrBanks[0][addr];
-		}
-		return 0;
+	void saveState(StateWriter& state) override {
+		state.write(prgBank);
+		state.write(mirrorPage);
 	}
 
-	void writeChr(uint16_t addr, uint8_t value) override {
-		// Allow writing to CHR-RAM
-		if (addr < 0x2000) {
-			cart->chrBanks[0][addr] = value;
-		}
+	void loadState(StateReader& state) override {
+		state.read(prgBank);
+		state.read(mirrorPage);
+		updateBanks();
 	}
 
-	int mirrorNametable(int ntIdx) override {
-		// Single Screen Mirroring.
-		// Regardless of the virtual nametable index (0-3), 
-		// we return the physical page set by the register (0 or 1).
-		return mirrorPage;
+private:
+	void updateBanks() {
+		selectPrg(0x8000, 0x8000, prgBank);
+		// single screen, the register picks which nametable
+		setMirroring(mirrorPage ? ONE_SCREEN_HIGH : ONE_SCREEN_LOW);
+		updatePages();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "latch.hpp"
+
+// fixed 16KB/32KB prg like NROM, 8KB switchable chr rom
+class CNROM : public LatchMapper {
+public:
+	CNROM(Cart* cartRef) : LatchMapper(cartRef, 3, true) {
+		reset();
+	}
+
+protected:
+	void updateBanks() override {
+		selectPrg(0x8000, 0x8000, 0);
+		// 2 bits on the original boards, some later ones decode more
+		selectChr(0x0000, 0x2000, latch);
+	}
+};
\ No newline at end of file
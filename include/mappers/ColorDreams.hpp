@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "latch.hpp"
+
+// unlicensed color dreams boards
+// bits 0-1: 32KB prg bank, bits 4-7: 8KB chr bank
+class ColorDreams : public LatchMapper {
+public:
+	ColorDreams(Cart* cartRef) : LatchMapper(cartRef, 11, true) {
+		reset();
+	}
+
+protected:
+	void updateBanks() override {
+		selectPrg(0x8000, 0x8000, latch & 0x03);
+		selectChr(0x0000, 0x2000, latch >> 4);
+	}
+};
\ No newline at end of file
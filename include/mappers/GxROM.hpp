@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "latch.hpp"
+
+// GNROM/MHROM, color dreams with the fields swapped
+// bits 4-5: 32KB prg bank, bits 0-1: 8KB chr bank
+class GxROM : public LatchMapper {
+public:
+	GxROM(Cart* cartRef) : LatchMapper(cartRef, 66, true) {
+		reset();
+	}
+
+protected:
+	void updateBanks() override {
+		selectPrg(0x8000, 0x8000, (latch >> 4) & 0x03);
+		selectChr(0x0000, 0x2000, latch & 0x03);
+	}
+};
\ No newline at end of file
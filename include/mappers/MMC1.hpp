@@ -1,6 +1,5 @@
 #pragma once
 
-#include <vector>
 #include <array>
 #include <cstdint>
 
@@ -35,17 +34,12 @@ public:
 	MMC1(Cart* cartRef) {
 		cart = cartRef;
 		mapperID = 1;
-		prgBankCount = cart->prgBanks.size();
-		chrBankCount = cart->chrBanks.size();
+		prgBankCount = cart->prgSize / 0x4000;
+		chrBankCount = cart->chrSize / 0x2000;
 
 		// MMC1 usually has 8KB WRAM
 		prgRam.fill(0);
 
-		// If no CHR ROM is present, allocate 8KB CHR RAM (treated as 1 bank)
-		if (chrBankCount == 0) {
-			cart->chrBanks.push_back(std::array<uint8_t, 0x2000>{});
-		}
-
 		reset();
 	}
 
@@ -69,14 +63,7 @@ public:
 		}
 
 		// PRG ROM
-		if (addr >= 0x8000) {
-			int bankIdx = (addr < 0xC000) ? prgBankIdx8000 : prgBankIdxC000;
-			
-			// Safety mask to keep index within vector size
-			if (prgBankCount > 0) bankIdx %= prgBankCount;
-			
-			return cart->prgBanks[bankIdx][addr & 0x3FFF];
-		}
+		if (addr >= 0x8000) return prgByte(addr);
 		return 0;
 	}
 
@@ -119,48 +106,37 @@ public:
 		}
 	}
 
-	uint8_t readChr(uint16_t addr) override {
-		// Resolve the 4KB chunk index
-		int bank4k = (addr < 0x1000) ? chrBankIdx0000 : chrBankIdx1000;
-		
-		// The cart vector holds 8KB chunks. We need to split them logic-wise.
-		// Vector Index = bank4k / 2
-		// Offset = (bank4k % 2) * 4096
-		
-		// If using CHR RAM (bank count 0 -> we added 1 in constructor),
-		// we just map to the first available bank usually.
-		int vecIdx = bank4k / 2;
-		int offset = (bank4k % 2) * 0x1000;
-
-		// Handle CHR RAM wrap-around or safety
-		if (cart->chrBanks.size() > 0) {
-			vecIdx %= cart->chrBanks.size();
-			return cart->chrBanks[vecIdx][offset + (addr & 0x0FFF)];
+	void updatePages() override {
+		// WRAM is read and written directly while enabled
+		if (prgRamEnabled) {
+			mapPrg(0x6000, 0x2000, prgRam.data(), true);
+		} else {
+			unmapPrg(0x6000, 0x2000);
 		}
-		return 0;
+
+		mapPrgSlots();
 	}
 
-	void writeChr(uint16_t addr, uint8_t value) override {
-		// Allow writing to CHR RAM
-		if (chrBankCount == 0) {
-			// Simple mapping for CHR RAM (usually just one 8KB bank)
-			cart->chrBanks[0][addr & 0x1FFF] = value;
-		}
+	void saveState(StateWriter& state) override {
+		state.write(shiftReg);
+		state.write(shiftCount);
+		state.write(control);
+		state.write(chrBank0);
+		state.write(chrBank1);
+		state.write(prgBank);
+		state.write(prgRam);
 	}
 
-	int mirrorNametable(int ntIdx) override {
-		// Control Register Bits 0-1:
-		// 0: One Screen Lower (Physical 0)
-		// 1: One Screen Upper (Physical 1)
-		// 2: Vertical
-		// 3: Horizontal
-		switch (control & 0x03) {
-			case 0: return 0;
-			case 1: return 1;
-			case 2: return (ntIdx % 2) ? 1 : 0; // Vertical (0,1,0,1)
-			case 3: return (ntIdx / 2) ? 1 : 0; // Horizontal (0,0,1,1)
-		}
-		return 0;
+	void loadState(StateReader& state) override {
+		state.read(shiftReg);
+		state.read(shiftCount);
+		state.read(control);
+		state.read(chrBank0);
+		state.read(chrBank1);
+		state.read(prgBank);
+		state.read(prgRam);
+		// bank indices and wram enable are derived from the registers
+		updateBanks();
 	}
 
 private:
@@ -203,5 +179,18 @@ private:
 			chrBankIdx0000 = chrBank0 & 0xFE;
 			chrBankIdx1000 = (chrBank0 & 0xFE) + 1;
 		}
+
+		selectPrg(0x8000, 0x4000, prgBankIdx8000);
+		selectPrg(0xC000, 0x4000, prgBankIdxC000);
+		// chr ram is banked the same way as chr rom
+		selectChr(0x0000, 0x1000, chrBankIdx0000);
+		selectChr(0x1000, 0x1000, chrBankIdx1000);
+
+		// --- Mirroring ---
+		// Control Bits 0-1: one screen lower, one screen upper, vertical, horizontal
+		static const int mirroringModes[4] = {ONE_SCREEN_LOW, ONE_SCREEN_HIGH, VERTICAL, HORIZONTAL};
+		setMirroring(mirroringModes[control & 0x03]);
+
+		updatePages();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "mapper.hpp"
+
+class MMC3 : public Mapper {
+private:
+	// Registers
+	uint8_t bankSelect = 0;  // $8000: target register, PRG mode (bit 6), CHR inversion (bit 7)
+	uint8_t registers[8] = {}; // $8001: R0-R1 2KB CHR, R2-R5 1KB CHR, R6-R7 8KB PRG
+	uint8_t mirroringMode = 0; // $A000: 0 vertical, 1 horizontal
+	uint8_t prgRamProtect = 0x80; // $A001: enabled (bit 7), write protected (bit 6)
+
+	// IRQ counter, clocked once per rendered scanline by the PPU
+	uint8_t irqLatch = 0;
+	uint8_t irqCounter = 0;
+	bool irqReload = false;
+	bool irqEnabled = false;
+
+	// PRG RAM (WRAM) at $6000
+	std::array<uint8_t, 0x2000> prgRam;
+
+	int prg8kCount = 0;
+
+public:
+	MMC3(Cart* cartRef) {
+		cart = cartRef;
+		mapperID = 4;
+		prgBankCount = cart->prgSize / 0x4000;
+		chrBankCount = cart->chrSize / 0x2000;
+		prg8kCount = cart->prgSize / 0x2000;
+
+		prgRam.fill(0);
+
+		reset();
+	}
+
+	void reset() override {
+		bankSelect = 0;
+		for (int i = 0; i < 8; i++) registers[i] = 0;
+		mirroringMode = 0;
+		prgRamProtect = 0x80;
+		irqLatch = 0;
+		irqCounter = 0;
+		irqReload = false;
+		irqEnabled = false;
+		setIRQ(false);
+		updateBanks();
+	}
+
+	uint8_t read(uint16_t addr) override {
+		// WRAM, only gets here while it's disabled
+		if (addr >= 0x6000 && addr <= 0x7FFF) {
+			if (prgRamProtect & 0x80) return prgRam[addr & 0x1FFF];
+			return 0;
+		}
+
+		// PRG ROM
+		if (addr >= 0x8000) return prgByte(addr);
+		return 0;
+	}
+
+	void write(uint16_t addr, uint8_t value) override {
+		// WRAM, only gets here while it's disabled or write protected
+		if (addr >= 0x6000 && addr <= 0x7FFF) {
+			if ((prgRamProtect & 0xC0) == 0x80) prgRam[addr & 0x1FFF] = value;
+			return;
+		}
+		if (addr < 0x8000) return;
+
+		// Registers come in even/odd pairs, one pair per 8KB
+		bool odd = addr & 1;
+		switch (addr & 0xE000) {
+			case 0x8000:
+				if (odd) registers[bankSelect & 0x07] = value;
+				else bankSelect = value;
+				updateBanks();
+				break;
+			case 0xA000:
+				if (odd) prgRamProtect = value;
+				else mirroringMode = value & 1;
+				updateBanks();
+				break;
+			case 0xC000:
+				if (odd) {
+					// Reload on the next clock
+					irqCounter = 0;
+					irqReload = true;
+				} else {
+					irqLatch = value;
+				}
+				break;
+			case 0xE000:
+				if (odd) {
+					irqEnabled = true;
+				} else {
+					// Disable and acknowledge
+					irqEnabled = false;
+					setIRQ(false);
+				}
+				break;
+		}
+	}
+
+	void clockScanline() override {
+		if (irqCounter == 0 || irqReload) {
+			irqCounter = irqLatch;
+			irqReload = false;
+		} else {
+			irqCounter--;
+		}
+		// newer (Sharp) behavior: a latch of 0 fires on every clock
+		if (irqCounter == 0 && irqEnabled) setIRQ(true);
+	}
+
+	int scanlinesToIRQ() override {
+		if (!irqEnabled) return -1;
+		// a reload takes one clock, then the latch counts down
+		if (irqCounter == 0 || irqReload) return irqLatch + 1;
+		return irqCounter;
+	}
+
+	void updatePages() override {
+		// WRAM is read and written directly while enabled, write protection
+		// sends writes through write() where they are dropped
+		if (prgRamProtect & 0x80) {
+			mapPrg(0x6000, 0x2000, prgRam.data(), (prgRamProtect & 0x40) == 0);
+		} else {
+			unmapPrg(0x6000, 0x2000);
+		}
+
+		mapPrgSlots();
+	}
+
+	void saveState(StateWriter& state) override {
+		state.write(bankSelect);
+		state.write(registers);
+		state.write(mirroringMode);
+		state.write(prgRamProtect);
+		state.write(irqLatch);
+		state.write(irqCounter);
+		state.write(irqReload);
+		state.write(irqEnabled);
+		state.write(prgRam);
+	}
+
+	void loadState(StateReader& state) override {
+		state.read(bankSelect);
+		state.read(registers);
+		state.read(mirroringMode);
+		state.read(prgRamProtect);
+		state.read(irqLatch);
+		state.read(irqCounter);
+		state.read(irqReload);
+		state.read(irqEnabled);
+		state.read(prgRam);
+		// the irq line itself is part of the cpu's state
+		updateBanks();
+	}
+
+private:
+	void updateBanks() {
+		// --- PRG Banking ---
+		// Bit 6 swaps R6 and the fixed second to last bank
+		// 0: R6 at $8000, second last at $C000
+		// 1: second last at $8000, R6 at $C000
+		// R7 is always at $A000 and the last bank at $E000
+		int secondLast = prg8kCount - 2;
+		bool prgSwap = bankSelect & 0x40;
+		selectPrg(0x8000, 0x2000, prgSwap ? secondLast : registers[6] & 0x3F);
+		selectPrg(0xA000, 0x2000, registers[7] & 0x3F);
+		selectPrg(0xC000, 0x2000, prgSwap ? registers[6] & 0x3F : secondLast);
+		selectPrg(0xE000, 0x2000, prg8kCount - 1);
+
+		// --- CHR Banking ---
+		// R0/R1 are 2KB banks (low bit ignored), R2-R5 1KB banks.
+		// Bit 7 swaps the 2KB half and the 1KB half
+		uint16_t twoKB = (bankSelect & 0x80) ? 0x1000 : 0x0000;
+		uint16_t oneKB = twoKB ^ 0x1000;
+		selectChr(twoKB, 0x0800, registers[0] >> 1);
+		selectChr(twoKB + 0x0800, 0x0800, registers[1] >> 1);
+		for (int i = 0; i < 4; i++) {
+			selectChr(oneKB + i * 0x0400, 0x0400, registers[2 + i]);
+		}
+
+		// --- Mirroring ---
+		// four screen boards have the extra vram wired up instead
+		if (cart->mirroring == FOUR_SCREEN) {
+			setMirroring(FOUR_SCREEN);
+		} else {
+			setMirroring(mirroringMode ? HORIZONTAL : VERTICAL);
+		}
+
+		updatePages();
+	}
+};
\ No newline at end of file
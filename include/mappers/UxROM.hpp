@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include "latch.hpp"
+
+// 16KB switchable at $8000, last 16KB fixed at $C000, 8KB chr ram
+class UxROM : public LatchMapper {
+public:
+	UxROM(Cart* cartRef) : LatchMapper(cartRef, 2, true) {
+		reset();
+	}
+
+protected:
+	void updateBanks() override {
+		// UNROM uses 3 bits, UOROM 4, larger banks wrap
+		selectPrg(0x8000, 0x4000, latch & 0x0F);
+		selectPrg(0xC000, 0x4000, lastPrg16k());
+		selectChr(0x0000, 0x2000, 0);
+	}
+};
\ No newline at end of file
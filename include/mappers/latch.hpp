@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mapper.hpp"
+
+// discrete logic boards: one register, written by storing anywhere in
+// $8000-$FFFF, and mirroring fixed by the header. a board only says how
+// the register value picks its banks in updateBanks.
+// boards without a write enable on the rom have bus conflicts: the rom
+// drives the data bus during the write too, and the value that sticks is
+// the AND of both. games avoid it by writing to a rom byte holding the
+// same value, so emulating it only matters for the ones that don't
+
+class LatchMapper : public Mapper {
+protected:
+	uint8_t latch = 0;
+	bool busConflicts = false;
+
+	LatchMapper(Cart* cartRef, int id, bool conflicts) {
+		cart = cartRef;
+		mapperID = id;
+		prgBankCount = cart->prgSize / 0x4000;
+		chrBankCount = cart->chrSize / 0x2000;
+		busConflicts = conflicts;
+		setMirroring(cart->mirroring);
+	}
+
+	// point the slots at the banks the latch selects
+	virtual void updateBanks() = 0;
+
+	// the fixed bank on boards that switch 16KB at $8000
+	int lastPrg16k() const {
+		return cart->prgSize / 0x4000 - 1;
+	}
+
+public:
+	void reset() override {
+		latch = 0;
+		updateBanks();
+		updatePages();
+	}
+
+	void write(uint16_t addr, uint8_t value) override {
+		if (addr < 0x8000) return;
+		latch = busConflicts ? value & prgByte(addr) : value;
+		updateBanks();
+		updatePages();
+	}
+
+	void saveState(StateWriter& state) override {
+		state.write(latch);
+	}
+
+	void loadState(StateReader& state) override {
+		state.read(latch);
+		updateBanks();
+		updatePages();
+	}
+};
\ No newline at end of file
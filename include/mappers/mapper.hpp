@@ -5,7 +5,10 @@
 
 #include <cstdint>
 
-class Cart;
+#include "bus.hpp"
+#include "cart.hpp"
+#include "cpu.hpp"
+#include "savestate.hpp"
 
 class Mapper {
 protected:
@@ -14,14 +17,142 @@ protected:
 	int chrBankCount;
 
 	Cart* cart;
+	Bus* bus = nullptr;
+	CPU* cpu = nullptr;
+
+	// one counter per 1KB of ppu pattern space, see chrChanged
+	uint32_t chrVersions[8] = {};
+
+	// what the cpu sees at $8000-$FFFF in 8KB slots and the ppu at
+	// $0000-$1FFF in 1KB slots, pointing into the cart's prg and chr.
+	// mappers move them with selectPrg/selectChr when a bank register is
+	// written, so an access is a single pointer add
+	uint8_t* prgSlots[4] = {};
+	uint8_t* chrSlots[8] = {};
+
+	// which of the ppu's 1KB nametables each of the four at $2000-$2FFF is
+	uint8_t nametables[4] = {0, 0, 1, 1};
+
+	void setMirroring(int type) {
+		static const uint8_t layouts[5][4] = {
+			{0, 0, 1, 1}, // HORIZONTAL
+			{0, 1, 0, 1}, // VERTICAL
+			{0, 1, 2, 3}, // FOUR_SCREEN
+			{0, 0, 0, 0}, // ONE_SCREEN_LOW
+			{1, 1, 1, 1}, // ONE_SCREEN_HIGH
+		};
+		for (int i = 0; i < 4; i++) nametables[i] = layouts[type][i];
+	}
+
+	// point the slots covering size bytes from addr at bank number bank of
+	// that size. banks past the end of the rom wrap around like the missing
+	// address lines on the board would
+	void selectPrg(uint16_t addr, uint32_t size, int bank) {
+		for (uint32_t offset = 0; offset < size; offset += 0x2000) {
+			prgSlots[((addr + offset) >> 13) & 3] = cart->prg + ((uint32_t)bank * size + offset) % cart->prgSize;
+		}
+	}
+	void selectChr(uint16_t addr, uint32_t size, int bank) {
+		for (uint32_t offset = 0; offset < size; offset += 0x400) {
+			uint32_t slot = ((addr + offset) >> 10) & 7;
+			uint8_t* data = cart->chr + ((uint32_t)bank * size + offset) % cart->chrSize;
+			if (chrSlots[slot] != data) chrChanged(slot << 10, 0x400);
+			chrSlots[slot] = data;
+		}
+	}
+
+	uint8_t& prgByte(uint16_t addr) {
+		return prgSlots[(addr >> 13) & 3][addr & 0x1FFF];
+	}
+	uint8_t& chrByte(uint16_t addr) {
+		return chrSlots[(addr >> 10) & 7][addr & 0x3FF];
+	}
+
+	// a chr ram byte shows up in every slot that maps its 1KB, not only
+	// the one it was written through
+	void writeChrRam(uint16_t addr, uint8_t value) {
+		uint8_t* page = chrSlots[(addr >> 10) & 7];
+		page[addr & 0x3FF] = value;
+		for (int slot = 0; slot < 8; slot++) {
+			if (chrSlots[slot] == page) chrVersions[slot]++;
+		}
+	}
+
+	// hold or release the cpu's irq line
+	void setIRQ(bool active) {
+		if (cpu) cpu->setIRQ(CPU::IRQ_MAPPER, active);
+	}
+
+	// hand the prg slots to the cpu page table
+	void mapPrgSlots() {
+		for (int slot = 0; slot < 4; slot++) {
+			mapPrg(0x8000 + slot * 0x2000, 0x2000, prgSlots[slot]);
+		}
+	}
+
+	// publish a bank to the cpu page table so reads skip the mapper entirely.
+	// mappers call these from updatePages whenever their banking changes
+	void mapPrg(uint16_t addr, uint32_t size, uint8_t* data, bool writable = false) {
+		if (bus) bus->mapPages(addr, size, data, writable);
+	}
+	void unmapPrg(uint16_t addr, uint32_t size) {
+		if (bus) bus->unmapPages(addr, size);
+	}
 
 public:
 
-	virtual uint8_t read(uint16_t addr) {return 0;}
+	// the defaults go through the slots, mappers only override what their
+	// board adds on top (registers, wram)
+	virtual uint8_t read(uint16_t addr) {return addr >= 0x8000 ? prgByte(addr) : 0;}
 	virtual void write(uint16_t addr, uint8_t value) {}
-	virtual uint8_t readChr(uint16_t addr) {return 0;}
-	virtual void writeChr(uint16_t addr, uint8_t value) {}
-	virtual int mirrorNametable(int ntIdx) {return ntIdx;}
+	virtual uint8_t readChr(uint16_t addr) {return chrByte(addr);}
+	virtual void writeChr(uint16_t addr, uint8_t value) {if (cart->chrRam) writeChrRam(addr, value);}
+	virtual int mirrorNametable(int ntIdx) {return nametables[ntIdx & 3];}
 	virtual void reset() {}
-	~Mapper() = default;
-};
\ No newline at end of file
+	// (re)map every cpu page the mapper owns
+	virtual void updatePages() {mapPrgSlots();}
+	// scanline counter, see Cart::clockScanline
+	virtual void clockScanline() {}
+	virtual int scanlinesToIRQ() {return -1;}
+	// banking registers and on-board ram. loading has to remap the pages
+	virtual void saveState(StateWriter& state) {}
+	virtual void loadState(StateReader& state) {}
+	virtual ~Mapper() = default;
+
+	// the cart reads chr and nametable mirroring straight out of these, so
+	// the ppu's fetches never call into the mapper. the arrays live as long
+	// as the mapper and mappers only ever change their contents
+	uint8_t* const* getChrSlots() const {
+		return chrSlots;
+	}
+	const uint8_t* getNametables() const {
+		return nametables;
+	}
+
+	// mappers call this when what the ppu sees at $0000-$1FFF changes, on chr
+	// ram writes and chr bank switches. the renderer's tile cache compares
+	// the versions and only decodes tiles again on pages that moved
+	void chrChanged(uint16_t addr, uint32_t size = 1) {
+		for (uint32_t page = addr >> 10; page <= ((addr + size - 1) >> 10) && page < 8; page++) {
+			chrVersions[page]++;
+		}
+	}
+	const uint32_t* getChrVersions() const {
+		return chrVersions;
+	}
+
+	void connectBus(Bus* busRef) {
+		bus = busRef;
+		updatePages();
+	}
+	void disconnectBus() {
+		bus = nullptr;
+	}
+	void connectCPU(CPU* cpuRef) {
+		cpu = cpuRef;
+	}
+	void disconnectCPU() {
+		if (cpu) cpu->setIRQ(CPU::IRQ_MAPPER, false);
+		cpu = nullptr;
+	}
+};
@@ -2,7 +2,7 @@
 
 #include <cstdint>
 
-inline uint32_t defaultARGBpal[64] = {
+inline const uint32_t defaultARGBpal[64] = {
 	0xFF747474, 0xFF24188C, 0xFF0000A8, 0xFF44009C, 0xFF8C0074, 0xFFA80010, 0xFFA40000, 0xFF7C0800,
 	0xFF402C00, 0xFF004400, 0xFF005000, 0xFF003C14, 0xFF183C5C, 0xFF000000, 0xFF000000, 0xFF000000,
 	0xFFBCBCBC, 0xFF0070EC, 0xFF2038EC, 0xFF8000F0, 0xFFBC00BC, 0xFFE40058, 0xFFD82800, 0xFFC84C0C,
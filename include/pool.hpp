@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Forward declarations
+class Console;
+
+// steps many independent consoles in parallel.
+// every worker thread has its own task deque, it works from the back of its
+// own deque and steals from the front of the others once it runs dry, so one
+// slow rom doesn't hold the whole batch back
+
+class ConsolePool {
+private:
+	struct Worker {
+		std::deque<Console*> tasks;
+		std::mutex lock;
+	};
+
+	std::vector<std::thread> threads;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::mutex batchLock;
+	std::condition_variable batchStart;
+	std::condition_variable batchDone;
+	uint64_t batchId = 0;
+	bool stopping = false;
+
+	int framesPerTask = 1;
+	std::atomic<int> remaining{0};
+
+	void workerLoop(int idx);
+	bool popTask(int idx, Console*& console);
+
+public:
+	// 0 threads means one per hardware thread
+	ConsolePool(int threadCount = 0);
+	~ConsolePool();
+
+	// advance every console by the given number of frames, returns when all are done
+	void stepFrames(const std::vector<Console*>& consoles, int frames);
+
+	int getThreadCount() const;
+};
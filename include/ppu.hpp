@@ -4,11 +4,14 @@
 #include <iostream>
 
 #include "registers.hpp"
+#include "tilecache.hpp"
 
 // Forward declarations
 class Cart;
 class Composite;
 class CPU;
+class StateWriter;
+class StateReader;
 
 class PPU {
 	friend Composite;
@@ -20,10 +23,15 @@ private:
 	PPUSTAT stat;
 	uint8_t oamaddr;
 	uint8_t oamdata;
-	PPUSCRL scrl;
-	PPUADDR addr;
 
-	bool w;
+	// loopy registers. v is the vram address and, while rendering, the scroll
+	// position being drawn. t is what $2000/$2005/$2006 write into and gets
+	// copied to v at the start of each line and frame. fineX is the pixel
+	// offset into the first tile
+	uint16_t v;
+	uint16_t t;
+	uint8_t fineX;
+	bool w; // true before the first write of a $2005/$2006 pair
 
 	uint8_t vram[0x1000];  // PPU VRAM
 	OAM oam;            // Object Attribute Memory (OAM)
@@ -35,6 +43,41 @@ private:
 	int scanline;       // Current PPU scanline
 	int frame;          // Current frame count
 
+	// secondary oam, the up to 8 sprites on the line about to be drawn in oam
+	// order. evaluation already resolves 8x16 tiles and vertical flips
+	struct SpriteLine {
+		struct Entry {
+			uint16_t patternAddr; // pattern table address of the tile
+			uint8_t row;          // row within that tile
+			uint8_t attr;
+			uint8_t x;
+		} sprites[8];
+		int count = 0;
+		bool hasSprite0 = false; // sprites[0] is oam sprite 0
+	} spriteLine;
+
+	void evaluateSprites(int line);
+	bool endLine();
+
+	// background pipeline.
+	// tiles are fetched at the dots the real ppu fetches them and v moves
+	// along the same way, but the work only happens when something could
+	// observe it (a register write or the end of the line). pixels come out
+	// of the fetched tiles shifted by fineX like the shift registers do
+	struct BackgroundTile {
+		uint8_t pixels[8]; // color 0-3
+		uint8_t palette;
+	};
+	BackgroundTile bgTiles[34]; // 0 and 1 are fetched at the end of the line before
+	uint8_t bgLine[256];        // palette ram indices, 0 is transparent
+	int renderDot;              // dots of this line that already ran
+	TileCache tiles;
+
+	void renderTo(int targetDot);
+	int scanlineClockDot();
+	void fetchTile(int index);
+	void incrementX();
+	void incrementY();
 
 	Cart* cart = nullptr;
 	Composite* comp = nullptr;
@@ -87,11 +130,9 @@ public:
 
 	// PPUSCRL
 	void SCRLwrite(uint8_t value);
-	PPUSCRL SCRLget();
 
 	// PPUADDR
 	void ADDRwrite(uint8_t value);
-	PPUADDR ADDRget();
 	void ADDRincrement(int inc);
 
 	// Read and Write
@@ -102,10 +143,27 @@ public:
 	void writeNametable(uint16_t addr, uint8_t value);
 
 	// PPU Cycles
+	// runs any number of dots, returns true if a frame ended in there
 	bool step(int cycles);
+	// dots until line 241 starts / line 261 ends, the bus schedules these
+	int dotsToVblank() const;
+	int dotsToFrameEnd() const;
+	// dots until the mapper's scanline counter has been clocked count more
+	// times, -1 when it isn't clocked at all. only valid right after catchUp
+	int dotsToScanlineClock(int count);
+	// render up to the current dot, called before anything that changes
+	// what the rest of the line would look like
+	void catchUp();
+	int getFrame();
+	int getScanline() const;
+	int getDot() const;
 
 	uint8_t useBuffer(uint8_t value);
 
+	// save states
+	void saveState(StateWriter& state);
+	void loadState(StateReader& state);
+
 	void connectComposite(Composite* comp);
 	void disconnectComposite();
 	void connectCPU(CPU* cpu);
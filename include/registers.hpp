@@ -46,23 +46,6 @@ union PPUSTAT {
 };
 
 
-struct PPUSCRL {
-	uint8_t x : 8; // X scroll
-	uint8_t y : 8; // Y scroll
-};
-
-union PPUADDR {
-	struct {
-		uint8_t low : 8;  // Low 8 bits of address
-		uint8_t high : 6; // High 6 bits of address
-		uint8_t unused : 2; // Unused to line up to the byte
-	};
-	struct {
-		uint16_t value : 14; // Full 14-bit address
-		uint8_t unused2 : 2; // Unused to line up to the byte
-	};	
-};
-
 union OAM {
 	struct {
 		uint8_t y : 8;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations
+class Console;
+
+// per frame rewind history.
+// the newest save state is kept in full and acts as the keyframe, every
+// older frame is stored as the xor of itself and the frame after it with
+// runs of zero bytes squeezed out. most of ram and vram is the same from one
+// frame to the next so a delta is usually a few hundred bytes.
+// deltas go into one fixed ring of bytes, when it is full the oldest frames
+// fall off the end, so the memory use never grows past what was asked for
+
+class Rewind {
+private:
+	struct Entry {
+		size_t offset;  // where the delta starts in the ring
+		uint32_t size;  // encoded size in bytes
+		uint32_t frame; // ppu frame of the state this delta restores
+	};
+
+	std::vector<uint8_t> ring;
+	size_t ringHead = 0; // next free byte
+	size_t ringUsed = 0;
+
+	std::vector<Entry> entries; // circular, oldest at entryFirst
+	size_t entryFirst = 0;
+	size_t entryCount = 0;
+
+	std::vector<uint8_t> current; // newest state in full
+	std::vector<uint8_t> next;    // scratch for the state being pushed
+	std::vector<uint8_t> delta;   // scratch for the encoded delta
+	size_t stateSize = 0;
+	uint32_t currentFrame = 0;
+
+	size_t encodeDelta(const uint8_t* older, const uint8_t* newer);
+	void applyDelta(const Entry& entry, uint8_t* state);
+	bool popNewest();
+	void dropOldest();
+	void ringWrite(const uint8_t* data, size_t size);
+
+public:
+	// bufferBytes bounds the delta storage, maxFrames bounds the history length
+	Rewind(size_t bufferBytes = 4 << 20, size_t maxFrames = 60 * 60 * 10);
+
+	void clear();
+
+	// record the console state, call once per frame
+	void push(Console& console);
+	// go back one frame, returns false once the history runs out
+	bool stepBack(Console& console);
+	// go back until the ppu frame counter is at or before frame
+	bool seekFrame(Console& console, uint32_t frame);
+
+	size_t getFrameCount() const;
+	size_t getMemoryUsed() const;
+	uint32_t getOldestFrame() const;
+};
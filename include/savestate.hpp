@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// binary save states.
+// every component writes its fields in a fixed order straight into a buffer
+// the caller owns, so taking a state never allocates. a writer without a
+// buffer only counts bytes, which is how Console::stateSize works
+
+const uint32_t SAVESTATE_MAGIC = 0x5453534E; // "NSST"
+const uint32_t SAVESTATE_VERSION = 5;
+
+class StateWriter {
+private:
+	uint8_t* data;
+	size_t capacity;
+	size_t pos = 0;
+	bool overflow = false;
+
+public:
+	StateWriter(uint8_t* data = nullptr, size_t capacity = 0) : data(data), capacity(capacity) {}
+
+	void writeBytes(const void* src, size_t size) {
+		if (data) {
+			if (pos + size > capacity) {
+				overflow = true;
+				return;
+			}
+			memcpy(data + pos, src, size);
+		}
+		pos += size;
+	}
+
+	template<typename T>
+	void write(const T& value) {
+		writeBytes(&value, sizeof(T));
+	}
+
+	size_t size() const { return pos; }
+	bool ok() const { return !overflow; }
+};
+
+class StateReader {
+private:
+	const uint8_t* data;
+	size_t capacity;
+	size_t pos = 0;
+	bool underflow = false;
+
+public:
+	StateReader(const uint8_t* data, size_t capacity) : data(data), capacity(capacity) {}
+
+	void readBytes(void* dst, size_t size) {
+		if (pos + size > capacity) {
+			underflow = true;
+			memset(dst, 0, size);
+			return;
+		}
+		memcpy(dst, data + pos, size);
+		pos += size;
+	}
+
+	template<typename T>
+	void read(T& value) {
+		readBytes(&value, sizeof(T));
+	}
+
+	size_t size() const { return pos; }
+	bool ok() const { return !underflow; }
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+// master clock event queue.
+// everything outside the cpu runs behind it and only has to be caught up
+// when the cpu looks at it or when something is due that the cpu would
+// notice on its own: vblank and nmi, the end of a frame, an apu irq, a dmc
+// sample fetch or a mapper irq. each of those is an event with a master clock timestamp in a
+// small min-heap, the cpu runs freely until the earliest one.
+// there is at most one event of each type, rescheduling one moves it in place
+
+// NTSC master clock dividers
+const int CPU_CLOCK_DIVIDER = 12;
+const int PPU_CLOCK_DIVIDER = 4;
+
+enum EventType : uint8_t {
+	EVENT_VBLANK,      // ppu enters vblank, nmi
+	EVENT_FRAME_END,   // ppu wraps to the next frame
+	EVENT_APU_FRAME,   // apu frame counter step, frame irq
+	EVENT_DMC_FETCH,   // dmc reads its next sample byte, dmc irq
+	EVENT_MAPPER_IRQ,  // the scanline the mapper's irq counter runs out on
+	EVENT_COUNT,
+};
+
+class Scheduler {
+public:
+	static const uint64_t NEVER = UINT64_MAX;
+
+private:
+	struct Event {
+		uint64_t time;
+		EventType type;
+	};
+
+	Event heap[EVENT_COUNT];
+	int position[EVENT_COUNT]; // heap index of each type, -1 when not scheduled
+	int count = 0;
+
+	void place(int index, const Event& event) {
+		heap[index] = event;
+		position[event.type] = index;
+	}
+
+	void siftUp(int index) {
+		Event event = heap[index];
+		while (index > 0) {
+			int parent = (index - 1) / 2;
+			if (heap[parent].time <= event.time) break;
+			place(index, heap[parent]);
+			index = parent;
+		}
+		place(index, event);
+	}
+
+	void siftDown(int index) {
+		Event event = heap[index];
+		while (true) {
+			int child = index * 2 + 1;
+			if (child >= count) break;
+			if (child + 1 < count && heap[child + 1].time < heap[child].time) child++;
+			if (event.time <= heap[child].time) break;
+			place(index, heap[child]);
+			index = child;
+		}
+		place(index, event);
+	}
+
+	void removeAt(int index) {
+		position[heap[index].type] = -1;
+		count--;
+		if (index == count) return;
+		place(index, heap[count]);
+		if (index > 0 && heap[(index - 1) / 2].time > heap[index].time) siftUp(index);
+		else siftDown(index);
+	}
+
+public:
+	Scheduler() {
+		clear();
+	}
+
+	void clear() {
+		count = 0;
+		for (int i = 0; i < EVENT_COUNT; i++) position[i] = -1;
+	}
+
+	// adds the event or moves it if it's already queued
+	void schedule(EventType type, uint64_t time) {
+		int index = position[type];
+		if (index < 0) {
+			index = count++;
+			place(index, {time, type});
+			siftUp(index);
+			return;
+		}
+		uint64_t old = heap[index].time;
+		heap[index].time = time;
+		if (time < old) siftUp(index);
+		else siftDown(index);
+	}
+
+	void cancel(EventType type) {
+		if (position[type] >= 0) removeAt(position[type]);
+	}
+
+	bool isScheduled(EventType type) const {
+		return position[type] >= 0;
+	}
+
+	uint64_t nextTime() const {
+		return count > 0 ? heap[0].time : NEVER;
+	}
+
+	// removes and returns the earliest event, only call when not empty
+	EventType pop() {
+		EventType type = heap[0].type;
+		removeAt(0);
+		return type;
+	}
+};
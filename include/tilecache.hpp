@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Forward declarations
+class Cart;
+
+// decoded pattern tables.
+// every tile in $0000-$1FFF is kept as 64 chunky bytes (color 0-3 per pixel)
+// plus a horizontally flipped copy, so drawing a tile row is 8 lookups
+// instead of two chr reads through the mapper and a bitplane shuffle per
+// pixel. tiles are decoded on first use and only thrown out when the mapper
+// reports a chr ram write or bank switch on their 1KB page
+
+class TileCache {
+private:
+	static const int TILE_COUNT = 512;
+	static const int PAGE_COUNT = 8;
+	static const int TILES_PER_PAGE = TILE_COUNT / PAGE_COUNT;
+
+	uint8_t pixels[TILE_COUNT][2][64]; // [tile][flipped][row * 8 + x]
+	bool valid[TILE_COUNT];
+	uint32_t pageVersions[PAGE_COUNT];
+
+	Cart* cart = nullptr;
+
+	void decode(int tile);
+
+public:
+	TileCache();
+
+	void invalidate();
+	// drops the tiles on pages the mapper changed since the last sync
+	void sync();
+
+	// 8 pixels of one row. addr is the pattern table address of the tile
+	const uint8_t* getRow(uint16_t addr, int row, bool flipX) {
+		int tile = (addr >> 4) & (TILE_COUNT - 1);
+		if (!valid[tile]) decode(tile);
+		return pixels[tile][flipX] + row * 8;
+	}
+
+	void connectCart(Cart* cart);
+	void disconnectCart();
+};
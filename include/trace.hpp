@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// cpu instruction trace.
+// the cpu hands every instruction over as a fixed size binary record, the
+// recorder either keeps the last N of them in a ring in memory or streams
+// them to a file through a large buffer. turning records into text happens
+// offline with formatTraceFile, so tracing costs a struct copy per
+// instruction instead of a formatted write
+
+struct TraceRecord {
+	uint64_t cycle;    // cpu cycle the instruction starts on
+	uint16_t pc;
+	uint16_t scanline; // ppu position at the same time
+	uint16_t dot;
+	uint8_t bytes[3];  // opcode and operands, only length of them are valid
+	uint8_t length;
+	uint8_t a;
+	uint8_t x;
+	uint8_t y;
+	uint8_t p;
+	uint8_t s;
+	uint8_t reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "trace files depend on the record layout");
+
+class TraceRecorder {
+private:
+	// a recorder that isn't started (or was stopped) still has somewhere to
+	// put records, a cpu left attached to it keeps a small ring
+	static const size_t IDLE_RECORDS = 256;
+
+	std::vector<TraceRecord> buffer;
+	size_t count = 0;       // records in the buffer (ring: next slot to write)
+	bool wrapped = false;   // ring only, the buffer has been filled at least once
+	uint64_t total = 0;     // records since start
+	FILE* file = nullptr;
+
+	void bufferFull();
+
+public:
+	TraceRecorder() : buffer(IDLE_RECORDS) {}
+	~TraceRecorder();
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	// keep the last capacity records in memory
+	void startRing(size_t capacity);
+	// write every record to path, bufferRecords at a time
+	bool startFile(const std::string& path, size_t bufferRecords = 1 << 16);
+	// flushes and closes the file, the ring stays readable. records after
+	// this go into the buffer as a ring
+	void stop();
+
+	void record(const TraceRecord& entry) {
+		buffer[count++] = entry;
+		total++;
+		if (count == buffer.size()) bufferFull();
+	}
+
+	// ring contents oldest first
+	std::vector<TraceRecord> getRecords() const;
+	uint64_t getTotal() const;
+};
+
+// one line in the format tests/verif-log.py compares:
+// C000 4C F5 C5 JMP a:00 x:00 y:00 p:00100100 sp:FD cyc:7
+// returns the length like snprintf
+int formatTraceRecord(const TraceRecord& entry, char* out, size_t size);
+// a whole trace file, one line per record
+bool formatTraceFile(const std::string& path, FILE* out);
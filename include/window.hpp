@@ -1,22 +1,26 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <iostream>
-#include <queue>
 #include <vector>
 #include <string>
 #include <ctime>
 
 #include <SDL2/SDL.h>
 
+#include "audioring.hpp"
+
 const int WIDTH = 256;
 const int HEIGHT = 240;
 const int PIXEL_SCALE = 2;
+// NTSC: 1789773 cpu cycles a second, 29780.5 per frame
+const double FRAME_RATE = 1789773.0 / 29780.5;
 
 class Window {
 private:
 	bool keep_window_open = true;
-	int64_t timeAlive = 0;
+	uint64_t nextFrameTime = 0; // performance counter deadline for the next present
 	
 	SDL_Window* window = nullptr;
 	SDL_Renderer* renderer = nullptr;
@@ -24,17 +28,36 @@ private:
 	
 	SDL_AudioDeviceID audio_device = 0;
 	SDL_AudioSpec audio_spec;
-	std::queue<std::vector<uint8_t>> audio_queue;
+
+	// samples go from queueAudio to the audio callback through the ring.
+	// queueAudio keeps at most audioMaxFill samples queued so the latency
+	// stays close to the target no matter how far ahead the emulation runs
+	AudioRing audioRing;
+	size_t audioTargetFill = 0;
+	size_t audioMaxFill = 0;
+	bool audioStarted = false; // the device waits for the first target's worth
+	int16_t audioLastSample = 0; // callback only
+	std::atomic<uint64_t> audioUnderruns{0};
+	uint64_t audioOverruns = 0;
+
+	static void audioCallback(void* userdata, Uint8* stream, int len);
 
 	// Helper to extract RGBA from uint32 (ARGB8888)
 	void setRenderColor(uint32_t color);
 
+	// sleeps most of the way, then spins the last stretch on the performance
+	// counter since sleeps can overshoot by a millisecond or more
+	void waitUntil(uint64_t deadline);
+
 public:
 	Window() {};
 
 	int StartWindow();
 	bool pollEvent(SDL_Event* event);
 	void updateSurface(double emulationSpeed = 1.0);
+	// move the next present by ms (negative is earlier), for pacing frames
+	// off something other than the timer
+	void shiftFrameDeadline(double ms);
 	void closeWindow();
 
 	void waitForVsync();
@@ -52,13 +75,23 @@ public:
 	void setLogicalSize(int width, int height);
 
 	// Audio functions
-	bool initAudio(int frequency = 44100, uint16_t format = AUDIO_S16SYS, int channels = 1, int samples = 2048);
-	void queueAudio(std::vector<uint8_t>* buffer);
+	// mono signed 16 bit. targetLatency is how much audio (in ms) should be
+	// queued ahead of the device, the device buffer is kept well below that
+	bool initAudio(int frequency = 44100, int targetLatency = 30);
+	void queueAudio(const int16_t* samples, size_t count);
 	void pauseAudio(bool pause_on);
-	uint32_t getQueuedAudioSize() const;
 	void clearAudioQueue();
 	void closeAudio();
 
+	struct AudioStats {
+		size_t queued;     // samples waiting in the ring
+		double queuedMs;
+		double targetMs;
+		uint64_t underruns; // callbacks that ran out of samples
+		uint64_t overruns;  // samples dropped because the ring was full
+	};
+	AudioStats getAudioStats() const;
+
 	// text rendering functions
 	void drawText(int x, int y, const std::string& text, uint32_t textColor = 0xFFFFFFFF);
 };
\ No newline at end of file
@@ -1,20 +1,794 @@
 #include "apu.hpp"
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "savestate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+// lookup tables shared by every apu, built once on first use
+struct APUTables {
+	// nonlinear mixer from https://www.nesdev.org/wiki/APU_Mixer
+	float pulse[31];
+	float tnd[203];
+	// band-limited impulse for each sub-sample phase, every row sums to 1
+	float kernel[64][16];
+
+	APUTables() {
+		pulse[0] = 0;
+		for (int i = 1; i < 31; i++) {
+			pulse[i] = 95.52f / (8128.0f / i + 100.0f);
+		}
+		tnd[0] = 0;
+		for (int i = 1; i < 203; i++) {
+			tnd[i] = 163.67f / (24329.0f / i + 100.0f);
+		}
+
+		// windowed sinc cut off a little under nyquist
+		const double cutoff = 0.45;
+		const int half = 8;
+		for (int phase = 0; phase < 64; phase++) {
+			double sum = 0;
+			for (int k = 0; k < 16; k++) {
+				double x = k - half - phase / 64.0 + 1;
+				double sinc = x == 0 ? 1.0 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+				double window = 0.42 + 0.5 * cos(M_PI * x / half) + 0.08 * cos(2 * M_PI * x / half);
+				if (fabs(x) >= half) window = 0;
+				kernel[phase][k] = sinc * window;
+				sum += kernel[phase][k];
+			}
+			for (int k = 0; k < 16; k++) {
+				kernel[phase][k] /= sum;
+			}
+		}
+	}
+};
+
+static const APUTables& tables() {
+	static const APUTables instance;
+	return instance;
+}
 
 
 APU::APU() {
-	// Placeholder for APU constructor
+	setSampleRate(sampleRate);
+	reset();
 }
 
 void APU::reset() {
-	// Placeholder for APU reset logic
+	pulse1 = Pulse();
+	pulse2 = Pulse();
+	triangle = Triangle();
+	noise = Noise();
+	dmc = DMC();
+
+	frameCycle = 0;
+	fiveStep = false;
+	irqInhibit = false;
+	frameIRQ = false;
+	dmcIRQ = false;
+	oddCycle = false;
+	updateIRQ();
+	pendingCycles = 0;
+	cyclesToEvent = cyclesToNextEvent();
+
+	timeOffset = 0;
+	frameTime = 0;
+	// start from the idle level so power on doesn't pop, only changes matter
+	lastLevel = tables().tnd[3 * triangleOutput()];
+	std::fill(std::begin(deltas), std::end(deltas), 0.0f);
+	sampleCount = 0;
+	integrator = 0;
+	filterIn = 0;
+	filterOut = 0;
 }
 
 void APU::step(int cycles) {
-	// Placeholder for APU step logic
+	// nothing can be heard or seen until the next event, so just count
+	pendingCycles += cycles / CPU_CLOCK_DIVIDER;
+	if (pendingCycles >= cyclesToEvent) catchUp();
+}
+
+void APU::catchUp() {
+	int remaining = pendingCycles;
+	pendingCycles = 0;
+	while (remaining > 0) {
+		// the output can only change when a timer runs out or the frame
+		// counter ticks, so jump straight to the cycle where that happens
+		int next = cyclesToNextEvent();
+		if (next > remaining) {
+			skipCycles(remaining);
+			break;
+		}
+		if (next > 1) skipCycles(next - 1);
+		clockCycle();
+		remaining -= next;
+	}
+	cyclesToEvent = cyclesToNextEvent();
+}
+
+int APU::cyclesToFrameStep() {
+	int next;
+	if (frameCycle < FRAME_STEP_1)      next = FRAME_STEP_1;
+	else if (frameCycle < FRAME_STEP_2) next = FRAME_STEP_2;
+	else if (frameCycle < FRAME_STEP_3) next = FRAME_STEP_3;
+	else if (!fiveStep)                 next = frameCycle < FRAME_STEP_4 ? FRAME_STEP_4 : FRAME_STEP_4 + 1;
+	else                                next = frameCycle < FRAME_STEP_5 ? FRAME_STEP_5 : FRAME_STEP_5 + 1;
+	return next - frameCycle;
+}
+
+int APU::cyclesToFrameCounter() {
+	return std::max(cyclesToFrameStep() - pendingCycles, 1) * CPU_CLOCK_DIVIDER;
+}
+
+int APU::cyclesToDMCFetch() {
+	// the next byte is read when the shift register runs empty on a timer
+	// clock, the sample can only end and raise its irq right there
+	if (dmc.bytesRemaining == 0) return -1;
+	int next = dmc.timer + 1 + (dmc.bitsRemaining - 1) * dmc.period;
+	return std::max(next - pendingCycles, 1) * CPU_CLOCK_DIVIDER;
+}
+
+int APU::cyclesToNextEvent() {
+	int next = cyclesToFrameStep();
+
+	// only channels that can be heard need their timers hit exactly.
+	// a timer runs out on the clock after it reaches 0
+	if (pulseOutputs(pulse1, true)) {
+		// pulse timers only clock on odd cycles
+		next = std::min(next, (oddCycle ? 1 : 2) + 2 * pulse1.timer);
+	}
+	if (pulseOutputs(pulse2, false)) {
+		next = std::min(next, (oddCycle ? 1 : 2) + 2 * pulse2.timer);
+	}
+	if (triangleRuns()) next = std::min(next, triangle.timer + 1);
+	if (noise.length > 0) next = std::min(next, noise.timer + 1);
+	if (!dmcIdle()) next = std::min(next, dmc.timer + 1);
+	return next;
+}
+
+// count a timer down by clocks, returns how many times it ran out
+static int advanceTimer(uint16_t& timer, int reload, int clocks) {
+	if (clocks <= timer) {
+		timer -= clocks;
+		return 0;
+	}
+	clocks -= timer + 1;
+	timer = reload - clocks % (reload + 1);
+	return 1 + clocks / (reload + 1);
+}
+
+void APU::skipCycles(int cycles) {
+	// audible timers don't run out in here, silent ones catch up in bulk
+	frameCycle += cycles;
+	frameTime += cycles;
+
+	int pulseClocks = oddCycle ? (cycles + 1) / 2 : cycles / 2;
+	pulse1.sequence = (pulse1.sequence + advanceTimer(pulse1.timer, pulse1.period, pulseClocks)) & 7;
+	pulse2.sequence = (pulse2.sequence + advanceTimer(pulse2.timer, pulse2.period, pulseClocks)) & 7;
+	if (cycles & 1) oddCycle = !oddCycle;
+
+	// a silent triangle doesn't step its sequence
+	advanceTimer(triangle.timer, triangle.period, cycles);
+
+	// the noise shift register keeps running while muted
+	for (int i = advanceTimer(noise.timer, noise.period - 1, cycles); i > 0; i--) {
+		uint16_t feedback = (noise.shift ^ (noise.shift >> (noise.mode ? 6 : 1))) & 1;
+		noise.shift = (noise.shift >> 1) | (feedback << 14);
+	}
+
+	// an idle dmc only shifts out zeros and counts its bits
+	int dmcClocks = advanceTimer(dmc.timer, dmc.period - 1, cycles);
+	if (dmcClocks > 0) {
+		dmc.shift = dmcClocks >= 8 ? 0 : dmc.shift >> dmcClocks;
+		dmc.bitsRemaining = (dmc.bitsRemaining - 1 + 8 - dmcClocks % 8) % 8 + 1;
+	}
+}
+
+bool APU::pulseOutputs(const Pulse& pulse, bool onesComplement) {
+	return pulse.length > 0 && pulse.period >= 8 && sweepTarget(pulse, onesComplement) <= 0x7FF;
+}
+
+bool APU::triangleRuns() {
+	// ultrasonic periods would just be noise, the sequence holds instead
+	return triangle.length > 0 && triangle.linearCounter > 0 && triangle.period >= 2;
+}
+
+bool APU::dmcIdle() {
+	return dmc.silence && dmc.bufferEmpty && dmc.bytesRemaining == 0;
+}
+
+void APU::clockCycle() {
+	// FRAME COUNTER
+	frameCycle++;
+	switch (frameCycle) {
+		case FRAME_STEP_1:
+		case FRAME_STEP_3:
+			clockQuarterFrame();
+			break;
+		case FRAME_STEP_2:
+			clockQuarterFrame();
+			clockHalfFrame();
+			break;
+		case FRAME_STEP_4:
+			if (!fiveStep) {
+				clockQuarterFrame();
+				clockHalfFrame();
+				if (!irqInhibit) {
+					frameIRQ = true;
+					updateIRQ();
+				}
+			}
+			break;
+		case FRAME_STEP_4 + 1:
+			if (!fiveStep) frameCycle = 0;
+			break;
+		case FRAME_STEP_5:
+			clockQuarterFrame();
+			clockHalfFrame();
+			break;
+		case FRAME_STEP_5 + 1:
+			frameCycle = 0;
+			break;
+	}
+
+	// TIMERS
+	if (oddCycle) {
+		clockPulseTimer(pulse1);
+		clockPulseTimer(pulse2);
+	}
+	oddCycle = !oddCycle;
+
+	if (triangle.timer == 0) {
+		triangle.timer = triangle.period;
+		if (triangleRuns()) {
+			triangle.sequence = (triangle.sequence + 1) & 31;
+		}
+	} else {
+		triangle.timer--;
+	}
+
+	if (noise.timer == 0) {
+		noise.timer = noise.period - 1;
+		uint16_t feedback = (noise.shift ^ (noise.shift >> (noise.mode ? 6 : 1))) & 1;
+		noise.shift = (noise.shift >> 1) | (feedback << 14);
+	} else {
+		noise.timer--;
+	}
+
+	if (dmc.timer == 0) {
+		dmc.timer = dmc.period - 1;
+		clockDMCOutput();
+	} else {
+		dmc.timer--;
+	}
+
+	mix();
+	frameTime++;
+}
+
+void APU::mix() {
+	const APUTables& t = tables();
+	float level =
+		t.pulse[pulseOutput(pulse1, true) + pulseOutput(pulse2, false)] +
+		t.tnd[3 * triangleOutput() + 2 * noiseOutput() + dmc.output];
+	if (level != lastLevel) {
+		addDelta(frameTime, level - lastLevel);
+		lastLevel = level;
+	}
+}
+
+void APU::clockQuarterFrame() {
+	clockEnvelope(pulse1.envelope);
+	clockEnvelope(pulse2.envelope);
+	clockEnvelope(noise.envelope);
+
+	if (triangle.linearReloadFlag) {
+		triangle.linearCounter = triangle.linearReload;
+	} else if (triangle.linearCounter > 0) {
+		triangle.linearCounter--;
+	}
+	if (!triangle.control) triangle.linearReloadFlag = false;
+}
+
+void APU::clockHalfFrame() {
+	if (!pulse1.envelope.loop && pulse1.length > 0) pulse1.length--;
+	if (!pulse2.envelope.loop && pulse2.length > 0) pulse2.length--;
+	if (!triangle.control && triangle.length > 0) triangle.length--;
+	if (!noise.envelope.loop && noise.length > 0) noise.length--;
+
+	clockSweep(pulse1, true);
+	clockSweep(pulse2, false);
+}
+
+void APU::clockEnvelope(Envelope& envelope) {
+	if (envelope.start) {
+		envelope.start = false;
+		envelope.decay = 15;
+		envelope.divider = envelope.volume;
+	} else if (envelope.divider == 0) {
+		envelope.divider = envelope.volume;
+		if (envelope.decay > 0) envelope.decay--;
+		else if (envelope.loop) envelope.decay = 15;
+	} else {
+		envelope.divider--;
+	}
+}
+
+uint16_t APU::sweepTarget(const Pulse& pulse, bool onesComplement) {
+	uint16_t change = pulse.period >> pulse.sweepShift;
+	if (pulse.sweepNegate) {
+		// pulse 1 adds the ones' complement, so it goes one lower
+		return pulse.period - change - (onesComplement ? 1 : 0);
+	}
+	return pulse.period + change;
+}
+
+void APU::clockSweep(Pulse& pulse, bool onesComplement) {
+	uint16_t target = sweepTarget(pulse, onesComplement);
+	bool muted = pulse.period < 8 || target > 0x7FF;
+	if (pulse.sweepDivider == 0 && pulse.sweepEnabled && pulse.sweepShift > 0 && !muted) {
+		pulse.period = target;
+	}
+	if (pulse.sweepDivider == 0 || pulse.sweepReload) {
+		pulse.sweepDivider = pulse.sweepPeriod;
+		pulse.sweepReload = false;
+	} else {
+		pulse.sweepDivider--;
+	}
+}
+
+void APU::clockPulseTimer(Pulse& pulse) {
+	if (pulse.timer == 0) {
+		pulse.timer = pulse.period;
+		pulse.sequence = (pulse.sequence + 1) & 7;
+	} else {
+		pulse.timer--;
+	}
+}
+
+void APU::clockDMCOutput() {
+	if (!dmc.silence) {
+		if (dmc.shift & 1) {
+			if (dmc.output <= 125) dmc.output += 2;
+		} else {
+			if (dmc.output >= 2) dmc.output -= 2;
+		}
+	}
+	dmc.shift >>= 1;
+
+	if (--dmc.bitsRemaining == 0) {
+		dmc.bitsRemaining = 8;
+		if (dmc.bufferEmpty) {
+			dmc.silence = true;
+		} else {
+			dmc.silence = false;
+			dmc.shift = dmc.sampleBuffer;
+			dmc.bufferEmpty = true;
+			fetchDMCSample();
+		}
+	}
+}
+
+void APU::fetchDMCSample() {
+	// the cpu stall while the sample byte is read is not emulated
+	if (!dmc.bufferEmpty || dmc.bytesRemaining == 0) return;
+
+	dmc.sampleBuffer = bus ? bus->read(dmc.currentAddr) : 0;
+	dmc.bufferEmpty = false;
+	dmc.currentAddr = dmc.currentAddr == 0xFFFF ? 0x8000 : dmc.currentAddr + 1;
+
+	if (--dmc.bytesRemaining == 0) {
+		if (dmc.loop) {
+			restartDMC();
+		} else if (dmc.irqEnabled) {
+			dmcIRQ = true;
+			updateIRQ();
+		}
+	}
+}
+
+void APU::restartDMC() {
+	dmc.currentAddr = dmc.sampleAddr;
+	dmc.bytesRemaining = dmc.sampleLength;
 }
 
-std::vector<uint8_t> APU::getAudioBuffer() {
-	// Placeholder for generating audio samples
-	// For now, return blank audio buffer
-	return std::vector<uint8_t>(44100);
-}
\ No newline at end of file
+void APU::updateIRQ() {
+	if (cpu) cpu->setIRQ(CPU::IRQ_APU, frameIRQ || dmcIRQ);
+}
+
+uint8_t APU::pulseOutput(const Pulse& pulse, bool onesComplement) {
+	if (!pulseOutputs(pulse, onesComplement) || !DUTY_TABLE[pulse.duty][pulse.sequence]) return 0;
+	return pulse.envelope.constant ? pulse.envelope.volume : pulse.envelope.decay;
+}
+
+uint8_t APU::triangleOutput() {
+	return TRIANGLE_TABLE[triangle.sequence];
+}
+
+uint8_t APU::noiseOutput() {
+	if (noise.length == 0 || (noise.shift & 1)) return 0;
+	return noise.envelope.constant ? noise.envelope.volume : noise.envelope.decay;
+}
+
+
+// REGISTERS
+
+void APU::writeRegister(uint16_t addr, uint8_t value) {
+	catchUp();
+	switch (addr) {
+		case 0x4000:
+		case 0x4004: {
+			Pulse& pulse = addr == 0x4000 ? pulse1 : pulse2;
+			pulse.duty = value >> 6;
+			pulse.envelope.loop = value & 0x20;
+			pulse.envelope.constant = value & 0x10;
+			pulse.envelope.volume = value & 0x0F;
+			break;
+		}
+		case 0x4001:
+		case 0x4005: {
+			Pulse& pulse = addr == 0x4001 ? pulse1 : pulse2;
+			pulse.sweepEnabled = value & 0x80;
+			pulse.sweepPeriod = (value >> 4) & 0x07;
+			pulse.sweepNegate = value & 0x08;
+			pulse.sweepShift = value & 0x07;
+			pulse.sweepReload = true;
+			break;
+		}
+		case 0x4002:
+		case 0x4006: {
+			Pulse& pulse = addr == 0x4002 ? pulse1 : pulse2;
+			pulse.period = (pulse.period & 0x700) | value;
+			break;
+		}
+		case 0x4003:
+		case 0x4007: {
+			Pulse& pulse = addr == 0x4003 ? pulse1 : pulse2;
+			pulse.period = (pulse.period & 0xFF) | ((value & 0x07) << 8);
+			if (pulse.enabled) pulse.length = LENGTH_TABLE[value >> 3];
+			pulse.sequence = 0;
+			pulse.envelope.start = true;
+			break;
+		}
+		case 0x4008:
+			triangle.control = value & 0x80;
+			triangle.linearReload = value & 0x7F;
+			break;
+		case 0x400A:
+			triangle.period = (triangle.period & 0x700) | value;
+			break;
+		case 0x400B:
+			triangle.period = (triangle.period & 0xFF) | ((value & 0x07) << 8);
+			if (triangle.enabled) triangle.length = LENGTH_TABLE[value >> 3];
+			triangle.linearReloadFlag = true;
+			break;
+		case 0x400C:
+			noise.envelope.loop = value & 0x20;
+			noise.envelope.constant = value & 0x10;
+			noise.envelope.volume = value & 0x0F;
+			break;
+		case 0x400E:
+			noise.mode = value & 0x80;
+			noise.period = NOISE_TABLE[value & 0x0F];
+			break;
+		case 0x400F:
+			if (noise.enabled) noise.length = LENGTH_TABLE[value >> 3];
+			noise.envelope.start = true;
+			break;
+		case 0x4010:
+			dmc.irqEnabled = value & 0x80;
+			dmc.loop = value & 0x40;
+			dmc.period = DMC_TABLE[value & 0x0F];
+			if (!dmc.irqEnabled) {
+				dmcIRQ = false;
+				updateIRQ();
+			}
+			break;
+		case 0x4011:
+			dmc.output = value & 0x7F;
+			break;
+		case 0x4012:
+			dmc.sampleAddr = 0xC000 | (value << 6);
+			break;
+		case 0x4013:
+			dmc.sampleLength = (value << 4) | 1;
+			break;
+		case 0x4015:
+			pulse1.enabled = value & 0x01;
+			pulse2.enabled = value & 0x02;
+			triangle.enabled = value & 0x04;
+			noise.enabled = value & 0x08;
+			if (!pulse1.enabled) pulse1.length = 0;
+			if (!pulse2.enabled) pulse2.length = 0;
+			if (!triangle.enabled) triangle.length = 0;
+			if (!noise.enabled) noise.length = 0;
+
+			if (!(value & 0x10)) {
+				dmc.bytesRemaining = 0;
+			} else if (dmc.bytesRemaining == 0) {
+				restartDMC();
+				fetchDMCSample();
+			}
+			dmcIRQ = false;
+			updateIRQ();
+			break;
+		case 0x4017:
+			fiveStep = value & 0x80;
+			irqInhibit = value & 0x40;
+			if (irqInhibit) {
+				frameIRQ = false;
+				updateIRQ();
+			}
+			// the sequence restarts, 5 step mode clocks everything right away
+			frameCycle = 0;
+			if (fiveStep) {
+				clockQuarterFrame();
+				clockHalfFrame();
+			}
+			break;
+		default:
+			break;
+	}
+	// register changes are heard right away, not at the next timer event
+	mix();
+	cyclesToEvent = cyclesToNextEvent();
+}
+
+uint8_t APU::readStatus() {
+	catchUp();
+	uint8_t status =
+		(pulse1.length > 0)       << 0 |
+		(pulse2.length > 0)       << 1 |
+		(triangle.length > 0)     << 2 |
+		(noise.length > 0)        << 3 |
+		(dmc.bytesRemaining > 0)  << 4 |
+		frameIRQ                  << 6 |
+		dmcIRQ                    << 7;
+	// reading acknowledges the frame interrupt
+	frameIRQ = false;
+	updateIRQ();
+	return status;
+}
+
+
+// OUTPUT
+
+void APU::addDelta(int time, float delta) {
+	uint64_t pos = timeOffset + (uint64_t)time * cycleFactor;
+	size_t idx = pos >> 32;
+	if (idx >= SAMPLE_CAPACITY) return; // endFrame hasn't been called in a long while
+	const float* kernel = tables().kernel[(pos >> (32 - PHASE_BITS)) & (PHASES - 1)];
+	float* out = deltas + idx;
+	for (int k = 0; k < KERNEL_WIDTH; k++) {
+		out[k] += delta * kernel[k];
+	}
+}
+
+void APU::endFrame() {
+	catchUp();
+	uint64_t end = timeOffset + (uint64_t)frameTime * cycleFactor;
+	size_t count = std::min<size_t>(end >> 32, SAMPLE_CAPACITY);
+	timeOffset = end & 0xFFFFFFFF;
+	frameTime = 0;
+	// the deltas already placed used the old factor, so only switch between frames
+	cycleFactor = nextCycleFactor;
+
+	// integrate the steps, then a one pole high pass (~35Hz) takes out the dc
+	// offset the way the coupling capacitor on the console does
+	for (size_t i = 0; i < count; i++) {
+		integrator += deltas[i];
+		filterOut = integrator - filterIn + 0.995f * filterOut;
+		filterIn = integrator;
+		float sample = filterOut * 24000.0f;
+		samples[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, sample));
+	}
+	sampleCount = count;
+
+	// the tail of the kernels belongs to the next frame
+	memmove(deltas, deltas + count, KERNEL_WIDTH * sizeof(float));
+	std::fill(deltas + KERNEL_WIDTH, deltas + count + KERNEL_WIDTH, 0.0f);
+}
+
+const int16_t* APU::getSamples() const {
+	return samples;
+}
+
+size_t APU::getSampleCount() const {
+	return sampleCount;
+}
+
+void APU::setSampleRate(int rate) {
+	sampleRate = rate;
+	cycleFactor = ((uint64_t)rate << 32) / CPU_CLOCK;
+	nextCycleFactor = cycleFactor;
+}
+
+void APU::setRateAdjust(double ratio) {
+	nextCycleFactor = (uint64_t)((double)((uint64_t)sampleRate << 32) * ratio / CPU_CLOCK);
+}
+
+int APU::getSampleRate() const {
+	return sampleRate;
+}
+
+
+void APU::saveEnvelope(StateWriter& state, const Envelope& envelope) {
+	state.write(envelope.start);
+	state.write(envelope.loop);
+	state.write(envelope.constant);
+	state.write(envelope.volume);
+	state.write(envelope.divider);
+	state.write(envelope.decay);
+}
+
+void APU::loadEnvelope(StateReader& state, Envelope& envelope) {
+	state.read(envelope.start);
+	state.read(envelope.loop);
+	state.read(envelope.constant);
+	state.read(envelope.volume);
+	state.read(envelope.divider);
+	state.read(envelope.decay);
+}
+
+void APU::saveChannel(StateWriter& state, const Pulse& pulse) {
+	state.write(pulse.enabled);
+	state.write(pulse.duty);
+	state.write(pulse.sequence);
+	state.write(pulse.period);
+	state.write(pulse.timer);
+	state.write(pulse.length);
+	saveEnvelope(state, pulse.envelope);
+	state.write(pulse.sweepEnabled);
+	state.write(pulse.sweepNegate);
+	state.write(pulse.sweepReload);
+	state.write(pulse.sweepPeriod);
+	state.write(pulse.sweepShift);
+	state.write(pulse.sweepDivider);
+}
+
+void APU::loadChannel(StateReader& state, Pulse& pulse) {
+	state.read(pulse.enabled);
+	state.read(pulse.duty);
+	state.read(pulse.sequence);
+	state.read(pulse.period);
+	state.read(pulse.timer);
+	state.read(pulse.length);
+	loadEnvelope(state, pulse.envelope);
+	state.read(pulse.sweepEnabled);
+	state.read(pulse.sweepNegate);
+	state.read(pulse.sweepReload);
+	state.read(pulse.sweepPeriod);
+	state.read(pulse.sweepShift);
+	state.read(pulse.sweepDivider);
+}
+
+void APU::saveChannel(StateWriter& state, const Triangle& tri) {
+	state.write(tri.enabled);
+	state.write(tri.control);
+	state.write(tri.linearReloadFlag);
+	state.write(tri.linearReload);
+	state.write(tri.linearCounter);
+	state.write(tri.sequence);
+	state.write(tri.period);
+	state.write(tri.timer);
+	state.write(tri.length);
+}
+
+void APU::loadChannel(StateReader& state, Triangle& tri) {
+	state.read(tri.enabled);
+	state.read(tri.control);
+	state.read(tri.linearReloadFlag);
+	state.read(tri.linearReload);
+	state.read(tri.linearCounter);
+	state.read(tri.sequence);
+	state.read(tri.period);
+	state.read(tri.timer);
+	state.read(tri.length);
+}
+
+void APU::saveChannel(StateWriter& state, const Noise& channel) {
+	state.write(channel.enabled);
+	state.write(channel.mode);
+	state.write(channel.period);
+	state.write(channel.timer);
+	state.write(channel.shift);
+	state.write(channel.length);
+	saveEnvelope(state, channel.envelope);
+}
+
+void APU::loadChannel(StateReader& state, Noise& channel) {
+	state.read(channel.enabled);
+	state.read(channel.mode);
+	state.read(channel.period);
+	state.read(channel.timer);
+	state.read(channel.shift);
+	state.read(channel.length);
+	loadEnvelope(state, channel.envelope);
+}
+
+void APU::saveChannel(StateWriter& state, const DMC& channel) {
+	state.write(channel.irqEnabled);
+	state.write(channel.loop);
+	state.write(channel.period);
+	state.write(channel.timer);
+	state.write(channel.output);
+	state.write(channel.sampleAddr);
+	state.write(channel.sampleLength);
+	state.write(channel.currentAddr);
+	state.write(channel.bytesRemaining);
+	state.write(channel.sampleBuffer);
+	state.write(channel.bufferEmpty);
+	state.write(channel.shift);
+	state.write(channel.bitsRemaining);
+	state.write(channel.silence);
+}
+
+void APU::loadChannel(StateReader& state, DMC& channel) {
+	state.read(channel.irqEnabled);
+	state.read(channel.loop);
+	state.read(channel.period);
+	state.read(channel.timer);
+	state.read(channel.output);
+	state.read(channel.sampleAddr);
+	state.read(channel.sampleLength);
+	state.read(channel.currentAddr);
+	state.read(channel.bytesRemaining);
+	state.read(channel.sampleBuffer);
+	state.read(channel.bufferEmpty);
+	state.read(channel.shift);
+	state.read(channel.bitsRemaining);
+	state.read(channel.silence);
+}
+
+// save states cover the channels and frame counter, not the audio already
+// synthesized for this frame
+void APU::saveState(StateWriter& state) {
+	catchUp();
+	saveChannel(state, pulse1);
+	saveChannel(state, pulse2);
+	saveChannel(state, triangle);
+	saveChannel(state, noise);
+	saveChannel(state, dmc);
+	state.write(frameCycle);
+	state.write(fiveStep);
+	state.write(irqInhibit);
+	state.write(frameIRQ);
+	state.write(dmcIRQ);
+	state.write(oddCycle);
+}
+
+void APU::loadState(StateReader& state) {
+	loadChannel(state, pulse1);
+	loadChannel(state, pulse2);
+	loadChannel(state, triangle);
+	loadChannel(state, noise);
+	loadChannel(state, dmc);
+	state.read(frameCycle);
+	state.read(fiveStep);
+	state.read(irqInhibit);
+	state.read(frameIRQ);
+	state.read(dmcIRQ);
+	state.read(oddCycle);
+	pendingCycles = 0;
+	cyclesToEvent = cyclesToNextEvent();
+}
+
+
+void APU::connectBus(Bus* busRef) {
+	bus = busRef;
+}
+
+void APU::disconnectBus() {
+	bus = nullptr;
+}
+
+void APU::connectCPU(CPU* cpuRef) {
+	cpu = cpuRef;
+}
+
+void APU::disconnectCPU() {
+	cpu = nullptr;
+}
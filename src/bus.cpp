@@ -3,6 +3,7 @@
 #include "ppu.hpp"
 #include "cart.hpp"
 #include "controller.hpp"
+#include "savestate.hpp"
 
 #include <algorithm>
 
@@ -11,6 +12,18 @@ Bus::Bus() {
 	// Initialize memory
 	std::fill(std::begin(memory), std::end(memory), 0);
 	cart = nullptr; // No cartridge loaded
+
+	std::fill(std::begin(readPages), std::end(readPages), nullptr);
+	std::fill(std::begin(writePages), std::end(writePages), nullptr);
+	std::fill(std::begin(mappedPages), std::end(mappedPages), nullptr);
+	std::fill(std::begin(cheatsOnPage), std::end(cheatsOnPage), 0);
+
+	// 2KB RAM mirrored every 0x800 bytes up to 0x1FFF
+	for (int addr = 0x0000; addr < 0x2000; addr += 0x800) {
+		mapPages(addr, 0x800, memory, true);
+	}
+
+	resetEvents();
 }
 
 void Bus::clearMem() {
@@ -18,13 +31,29 @@ void Bus::clearMem() {
 	std::fill(std::begin(memory), std::end(memory), 0);
 }
 
-uint8_t Bus::read(uint16_t addr) {
+uint8_t Bus::readSlow(uint16_t addr) {
+	if (cheatsOnPage[addr >> PAGE_SHIFT]) {
+		// check if there's a cheat for the address
+		for (const Cheat& cheat : cheats) {
+			if (cheat.addr != addr) continue;
+			if (cheat.compare < 0) return cheat.value;
+			// compare codes need the real byte first
+			uint8_t val = readUnpatched(addr);
+			return val == cheat.compare ? cheat.value : val;
+		}
+	}
+	return readUnpatched(addr);
+}
 
-	// check if there's a cheat for the address
-	if (cheats.find(addr) != cheats.end()) {
-		return cheats[addr];
+uint8_t Bus::readUnpatched(uint16_t addr) {
+	// mapped page that only got here because of cheats
+	if (uint8_t* page = mappedPages[addr >> PAGE_SHIFT]) {
+		return page[addr & (PAGE_SIZE - 1)];
 	}
 
+	// ppu and apu registers see the state as of this instruction
+	if (addr >= 0x2000 && addr <= 0x4017) sync();
+
 	switch (addr) {
 		case 0x0000 ... 0x1FFF: // 2KB RAM
 			// mirror the 2KB RAM every 0x800 bytes
@@ -37,9 +66,11 @@ uint8_t Bus::read(uint16_t addr) {
 			return ppu->read();
 		case 0x2008 ... 0x3FFF: // ppu registers mirror
 			return read(0x2000 | (addr & 0x7));
-		case 0x4000 ... 0x4015: // APU and I/O registers
-			// Placeholder for APU and I/O register read
+		case 0x4000 ... 0x4014: // APU registers are write only
 			return 0;
+		case 0x4015:
+			if (apu) return apu->readStatus();
+			else return 0;
 		case 0x4016:
 			if (controller1) return controller1->read();
 			else return 0;
@@ -57,16 +88,24 @@ uint8_t Bus::read(uint16_t addr) {
 	}
 }
 
-void Bus::write(uint16_t addr, uint8_t val) {
+void Bus::writeSlow(uint16_t addr, uint8_t val) {
+	// ppu/apu registers and mapper writes take effect at this point in time
+	if (addr >= 0x2000 && (addr <= 0x4017 || addr >= 0x4020)) sync();
+
 	switch (addr) {
 		case 0x0000 ... 0x1FFF: // 2KB RAM
 			memory[addr & 0x7FF] = val;
 			break;
 		case 0x2000:
 			if (ppu) ppu->CTRLwrite(val);
+			// the pattern tables decide when a scanline counter gets clocked
+			scheduleMapper();
+			updateDeadline();
 			break;
 		case 0x2001:
 			if (ppu) ppu->MASKwrite(val);
+			scheduleMapper();
+			updateDeadline();
 			break;
 		case 0x2003:
 			if (ppu) ppu->OAMADDRwrite(val);
@@ -86,8 +125,10 @@ void Bus::write(uint16_t addr, uint8_t val) {
 		case 0x2008 ... 0x3FFF:
 			write(0x2000 | (addr & 0x7), val);
 			break;
-		case 0x4000 ... 0x4013: // APU/IO registers
-			// APU/IO write logic here
+		case 0x4000 ... 0x4013: // APU registers
+			if (apu) apu->writeRegister(addr, val);
+			scheduleAPU();
+			updateDeadline();
 			break;
 		case 0x4014: // OAM DMA
 			if (ppu) {
@@ -99,17 +140,26 @@ void Bus::write(uint16_t addr, uint8_t val) {
 				ppu->OAMDMAwrite(data);
 			}
 			break;
-		case 0x4015:
-			// APU status write logic here
+		case 0x4015: // APU channel enable
+			if (apu) apu->writeRegister(addr, val);
+			scheduleAPU();
+			updateDeadline();
 			break;
-		case 0x4016:
+		case 0x4016: // the strobe goes to both ports
 			if (controller1) controller1->write(val);
-			break;
-		case 0x4017:
 			if (controller2) controller2->write(val);
 			break;
+		case 0x4017: // APU frame counter, reads go to controller 2
+			if (apu) apu->writeRegister(addr, val);
+			scheduleAPU();
+			updateDeadline();
+			break;
 		case 0x4020 ... 0xffff:
+			// bank switches and mirroring changes only apply from here on
+			if (ppu) ppu->catchUp();
 			if (cart && !cart->blank) cart->write(addr, val); // Delegate to cartridge
+			scheduleMapper();
+			updateDeadline();
 			break;
 		default:
 			// unmapped, do nothing
@@ -117,23 +167,170 @@ void Bus::write(uint16_t addr, uint8_t val) {
 	}
 }
 
+void Bus::mapPages(uint16_t addr, uint32_t size, uint8_t* data, bool writable) {
+	int first = addr >> PAGE_SHIFT;
+	int count = size >> PAGE_SHIFT;
+	for (int i = 0; i < count && first + i < PAGE_COUNT; i++) {
+		uint8_t* page = data ? data + i * PAGE_SIZE : nullptr;
+		mappedPages[first + i] = page;
+		writePages[first + i] = writable ? page : nullptr;
+		updateCheatPage(first + i);
+	}
+}
+
+void Bus::unmapPages(uint16_t addr, uint32_t size) {
+	mapPages(addr, size, nullptr, false);
+}
+
+void Bus::updateCheatPage(int page) {
+	readPages[page] = cheatsOnPage[page] ? nullptr : mappedPages[page];
+}
 
-bool Bus::clock(int cycles) {
-	// cpu sends in cycles passed * 12 to get master clock cycles
-	if (apu) {
-		apu->step(cycles);
+void Bus::addCheat(uint16_t addr, uint8_t value, int compare) {
+	for (Cheat& cheat : cheats) {
+		if (cheat.addr == addr) {
+			// replace the existing cheat for this address
+			cheat.value = value;
+			cheat.compare = compare;
+			return;
+		}
 	}
-	// do ppu last to pass nmi
-	if (ppu) {
-		return ppu->step(cycles / 4);
+	cheats.push_back({addr, value, compare});
+	cheatsOnPage[addr >> PAGE_SHIFT]++;
+	updateCheatPage(addr >> PAGE_SHIFT);
+}
+
+bool Bus::removeCheat(uint16_t addr) {
+	for (size_t i = 0; i < cheats.size(); i++) {
+		if (cheats[i].addr == addr) {
+			cheats.erase(cheats.begin() + i);
+			cheatsOnPage[addr >> PAGE_SHIFT]--;
+			updateCheatPage(addr >> PAGE_SHIFT);
+			return true;
+		}
 	}
-	// if there's no ppu, just return false
 	return false;
 }
 
+void Bus::clearCheats() {
+	cheats.clear();
+	std::fill(std::begin(cheatsOnPage), std::end(cheatsOnPage), 0);
+	for (int page = 0; page < PAGE_COUNT; page++) {
+		updateCheatPage(page);
+	}
+}
+
+const std::vector<Cheat>& Bus::getCheats() const {
+	return cheats;
+}
+
+
+void Bus::sync() {
+	if (pendingCycles > 0) {
+		int cycles = pendingCycles;
+		pendingCycles = 0;
+		masterClock += cycles;
+		if (apu) apu->step(cycles);
+		if (ppu && ppu->step(cycles / PPU_CLOCK_DIVIDER)) frameDone = true;
+	}
+
+	// whatever came due has happened by now, queue the next one
+	while (scheduler.nextTime() <= masterClock) {
+		switch (scheduler.pop()) {
+			case EVENT_VBLANK:
+			case EVENT_FRAME_END:
+				schedulePPU();
+				break;
+			case EVENT_APU_FRAME:
+			case EVENT_DMC_FETCH:
+				scheduleAPU();
+				break;
+			case EVENT_MAPPER_IRQ:
+				// the counter is clocked when the ppu draws past that dot
+				scheduleMapper();
+				break;
+			default:
+				break;
+		}
+	}
+	updateDeadline();
+}
+
+void Bus::getPPUPosition(int& scanline, int& dot) {
+	if (!ppu) return;
+	sync();
+	scanline = ppu->getScanline();
+	dot = ppu->getDot();
+}
+
+bool Bus::syncSlow() {
+	sync();
+	bool done = frameDone;
+	frameDone = false;
+	return done;
+}
+
+void Bus::updateDeadline() {
+	// a frame that ended in the middle of an instruction is reported by the
+	// next clock. without any events still sync once a frame so the count
+	// can't overflow
+	uint64_t next = scheduler.nextTime() - masterClock;
+	syncDeadline = frameDone ? 0 : (int)std::min<uint64_t>(next, FRAME_CYCLES);
+}
+
+void Bus::schedulePPU() {
+	if (!ppu) return;
+	scheduler.schedule(EVENT_VBLANK, masterClock + (uint64_t)ppu->dotsToVblank() * PPU_CLOCK_DIVIDER);
+	scheduler.schedule(EVENT_FRAME_END, masterClock + (uint64_t)ppu->dotsToFrameEnd() * PPU_CLOCK_DIVIDER);
+}
+
+void Bus::scheduleAPU() {
+	if (!apu) return;
+	scheduler.schedule(EVENT_APU_FRAME, masterClock + apu->cyclesToFrameCounter());
+	int fetch = apu->cyclesToDMCFetch();
+	if (fetch >= 0) scheduler.schedule(EVENT_DMC_FETCH, masterClock + fetch);
+	else scheduler.cancel(EVENT_DMC_FETCH);
+}
+
+void Bus::scheduleMapper() {
+	int lines = cart ? cart->scanlinesToIRQ() : -1;
+	int dots = -1;
+	if (lines >= 0 && ppu) {
+		// counts from what the ppu has drawn, which has to be up to now
+		ppu->catchUp();
+		dots = ppu->dotsToScanlineClock(lines);
+	}
+	if (dots >= 0) scheduler.schedule(EVENT_MAPPER_IRQ, masterClock + (uint64_t)dots * PPU_CLOCK_DIVIDER);
+	else scheduler.cancel(EVENT_MAPPER_IRQ);
+}
+
+void Bus::resetEvents() {
+	// everything is due right away, the next sync asks the ppu and apu again
+	scheduler.clear();
+	for (int type = 0; type < EVENT_COUNT; type++) {
+		scheduler.schedule((EventType)type, masterClock);
+	}
+	syncDeadline = 0;
+}
+
+void Bus::saveState(StateWriter& state) {
+	state.write(memory);
+	state.write(pendingCycles);
+	state.write(frameDone);
+}
+
+void Bus::loadState(StateReader& state) {
+	state.read(memory);
+	state.read(pendingCycles);
+	state.read(frameDone);
+	// the events depend on the ppu and apu, queue them again on the next clock
+	resetEvents();
+}
+
 
 void Bus::connectAPU(APU* apuRef) {
 	apu = apuRef;
+	resetEvents();
 }
 
 void Bus::disconnectAPU() {
@@ -142,6 +339,7 @@ void Bus::disconnectAPU() {
 
 void Bus::connectPPU(PPU* ppuRef) {
 	ppu = ppuRef;
+	resetEvents();
 }
 
 void Bus::disconnectPPU() {
@@ -149,11 +347,17 @@ void Bus::disconnectPPU() {
 }
 
 void Bus::connectCart(Cart* cartRef) {
+	disconnectCart();
 	cart = cartRef;
+	// let the mapper publish its banks to the page table
+	if (cart) cart->connectBus(this);
 }
 
 void Bus::disconnectCart() {
+	if (cart) cart->disconnectBus();
 	cart = nullptr;
+	// everything from the expansion area up belongs to the cartridge
+	unmapPages(0x4000, 0xC000);
 }
 
 void Bus::connectController1(Controller* controller1Ref) {
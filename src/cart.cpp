@@ -1,13 +1,33 @@
 #include "cart.hpp"
+#include "mappers/mapper.hpp"
 #include "mappers/NROM.hpp"  // mapper 0
 #include "mappers/MMC1.hpp"  // mapper 1
+#include "mappers/UxROM.hpp" // mapper 2
+#include "mappers/CNROM.hpp" // mapper 3
+#include "mappers/MMC3.hpp"  // mapper 4
 #include "mappers/AxROM.hpp" // mapper 7
+#include "mappers/ColorDreams.hpp" // mapper 11
+#include "mappers/GxROM.hpp" // mapper 66
+#include "savestate.hpp"
+
+#include <cstring>
 
 Cart::Cart() {
 
 }
 
-Cart::Cart(std::string fName) {
+Cart::~Cart() {
+	delete mapper;
+}
+
+// nes 2.0 rom sizes are a bank count with 4 extra high bits, or when those
+// bits are all set, 2^exponent * (multiplier * 2 + 1) bytes
+static uint64_t romBytes(uint8_t low, uint8_t high, uint32_t bankSize) {
+	if (high == 0x0F) return ((uint64_t)1 << (low >> 2)) * ((low & 0x03) * 2 + 1);
+	return (uint64_t)(high << 8 | low) * bankSize;
+}
+
+Cart::Cart(std::string fName, const HeaderDatabase* database) {
 	blank = true; // Default to blank until successfully loaded
 	mapper = nullptr;
 
@@ -18,39 +38,76 @@ Cart::Cart(std::string fName) {
 		return; // silently return if no filename provided
 	}
 
-	// Load ROM file
-	FILE* romFile = fopen(filename.c_str(), "rb");
-	if (!romFile) {
+	// Map ROM file, pages are only read in as they are touched
+	if (!file.open(filename)) {
 		loadStatus = LOAD_FILE_NOT_FOUND;
 		return; // silently return if file cannot be opened
 	}
 
-	// Read header
-	fread(header, sizeof(uint8_t), 16, romFile);
-
 	// Verify NES file format
-	if (header[0] != 'N' || header[1] != 'E' || header[2] != 'S' || header[3] != 0x1A) {
-		fclose(romFile);
+	const uint8_t* data = file.data();
+	if (file.size() < 16 || data[0] != 'N' || data[1] != 'E' || data[2] != 'S' || data[3] != 0x1A) {
+		file.close();
 		loadStatus = LOAD_INVALID_FORMAT;
 		return; // silently return if invalid NES file format
 	}
+	memcpy(header, data, 16);
 
 	// Parse header information
-	romBankCount = header[4];
-	romSize = romBankCount * 0x4000; // 16KB units
-	chrBankCount = header[5];
-	chrSize = chrBankCount * 0x2000; // 8KB units
-
 	uint8_t control1 = header[6];
 	uint8_t control2 = header[7];
 
-	mapperID = (control1 >> 4) | (control2 & 0xF0);
+	iNESVersion = ((control2 >> 2) & 0b00000011) == 2 ? 2 : 1;
+
+	uint64_t prgBytes, chrBytes;
+	if (iNESVersion == 2) {
+		mapperID = (control1 >> 4) | (control2 & 0xF0) | ((header[8] & 0x0F) << 8);
+		submapperID = header[8] >> 4;
+		prgBytes = romBytes(header[4], header[9] & 0x0F, 0x4000);
+		chrBytes = romBytes(header[5], header[9] >> 4, 0x2000);
+	} else {
+		// old dumping tools left their name in bytes 7-15 ("DiskDude!"),
+		// the high mapper nibble is garbage then
+		bool dirty = header[12] || header[13] || header[14] || header[15];
+		mapperID = (control1 >> 4) | (dirty ? 0 : (control2 & 0xF0));
+		prgBytes = header[4] * 0x4000;
+		chrBytes = header[5] * 0x2000;
+	}
+	romBankCount = prgBytes / 0x4000; // 16KB units
+	chrBankCount = chrBytes / 0x2000; // 8KB units
+
+	if (prgBytes == 0 || prgBytes > MAX_ROM_SIZE || chrBytes > MAX_ROM_SIZE) {
+		file.close();
+		loadStatus = LOAD_INVALID_FORMAT;
+		return; // nothing for the cpu to run, or a broken size
+	}
 
 	fourScreen        = (control1 & 0b00001000) != 0;
 	hasTrainer        = (control1 & 0b00000100) != 0;
 	batteryBacked     = (control1 & 0b00000010) != 0;
 	verticalMirroring = (control1 & 0b00000001) != 0;
 
+	trainerSize = hasTrainer ? 512 : 0;
+
+	// PRG and CHR ROM follow each other in the file (after the trainer),
+	// the hash covers both in one pass over the mapping
+	size_t romOffset = 16 + trainerSize;
+	size_t available = file.size() > romOffset ? file.size() - romOffset : 0;
+	size_t romLength = prgBytes + chrBytes;
+	crc = crc32(data + romOffset, romLength < available ? romLength : available);
+
+	// known bad headers, the contents say which rom this really is
+	const HeaderFix* fix = database ? database->find(crc) : nullptr;
+	if (fix) {
+		if (fix->mapper >= 0) mapperID = fix->mapper;
+		if (fix->mirroring >= 0) {
+			fourScreen = fix->mirroring == FOUR_SCREEN;
+			verticalMirroring = fix->mirroring == VERTICAL;
+		}
+		if (fix->battery >= 0) batteryBacked = fix->battery;
+		headerFixed = true;
+	}
+
 	if (fourScreen) {
 		mirroring = FOUR_SCREEN;
 	} else if (verticalMirroring) {
@@ -59,39 +116,55 @@ Cart::Cart(std::string fName) {
 		mirroring = HORIZONTAL;
 	}
 
-	iNESVersion = (control2 >> 2) & 0b00000011;
-	trainerSize = hasTrainer ? 512 : 0;
-
-	// Skip trainer if present
-	if (hasTrainer) {
-		fseek(romFile, 512, SEEK_CUR);
+	// the mappers bank in 8KB prg and 1KB chr units, odd sizes are padded
+	prgSize = (prgBytes + 0x1FFF) & ~0x1FFF;
+	chrRam = chrBytes == 0;
+	if (chrRam) {
+		// nes 2.0 gives the size, 8KB for everything else
+		int shift = header[11] & 0x0F;
+		chrSize = (iNESVersion == 2 && shift > 7) ? 64 << shift : 0x2000;
+	} else {
+		chrSize = (chrBytes + 0x3FF) & ~0x3FF;
 	}
 
-	// Load PRG ROM banks
-	for (int i = 0; i < romBankCount; i++) {
-		std::array<uint8_t, 0x4000> bank{};
-		fread(bank.data(), sizeof(uint8_t), 0x4000, romFile);
-		prgBanks.push_back(bank);
-	}
-	// Load CHR ROM banks
-	for (int i = 0; i < chrBankCount; i++) {
-		std::array<uint8_t, 0x2000> bank{};
-		fread(bank.data(), sizeof(uint8_t), 0x2000, romFile);
-		chrBanks.push_back(bank);
+	if (available >= romLength && prgSize == prgBytes && (chrRam || chrSize == chrBytes)) {
+		// the banks are used straight out of the mapping, only chr ram
+		// needs memory of its own
+		prg = file.data() + romOffset;
+		if (chrRam) {
+			chr = allocate(chrSize);
+		} else {
+			chr = prg + prgSize;
+		}
+	} else {
+		// a short or oddly sized file is copied, the rest stays zeroed
+		prg = allocate(prgSize + chrSize);
+		chr = prg + prgSize;
+		size_t prgAvailable = prgBytes < available ? prgBytes : available;
+		memcpy(prg, data + romOffset, prgAvailable);
+		if (!chrRam && available > prgBytes) {
+			memcpy(chr, data + romOffset + prgBytes, chrBytes < available - prgBytes ? chrBytes : available - prgBytes);
+		}
+		file.close();
 	}
 
-	fclose(romFile);
-
 	pickMapper(mapperID);
 
 	if (mapper) {
 		loadStatus = LOAD_SUCCESS;
 		blank = false;
+		setDirectAccess(true);
 	} else {
 		loadStatus = LOAD_UNSUPPORTED_MAPPER;
 	}
 }
 
+uint8_t* Cart::allocate(size_t size) {
+	storage.assign(size + STORAGE_ALIGN, 0);
+	uintptr_t misalign = (uintptr_t)storage.data() & (STORAGE_ALIGN - 1);
+	return storage.data() + (misalign ? STORAGE_ALIGN - misalign : 0);
+}
+
 uint8_t Cart::read(uint16_t addr) {
 	if (mapper && !blank) {
 		return mapper->read(addr);
@@ -107,7 +180,7 @@ void Cart::write(uint16_t addr, uint8_t val) {
 	}
 }
 
-uint8_t Cart::readChr(uint16_t addr) {
+uint8_t Cart::readChrSlow(uint16_t addr) {
 	if (mapper && !blank) {
 		return mapper->readChr(addr);
 		// leave handling up to mapper
@@ -122,12 +195,70 @@ void Cart::writeChr(uint16_t addr, uint8_t val) {
 	}
 }
 
-int Cart::mirrorNametable(int ntIdx) {
+int Cart::mirrorNametableSlow(int ntIdx) {
 	if (mapper)
 		return mapper->mirrorNametable(ntIdx);
 	return ntIdx; // default no mirror
 }
 
+void Cart::clockScanline() {
+	if (mapper && !blank)
+		mapper->clockScanline();
+}
+
+int Cart::scanlinesToIRQ() {
+	if (mapper && !blank)
+		return mapper->scanlinesToIRQ();
+	return -1;
+}
+
+void Cart::setDirectAccess(bool enabled) {
+	bool direct = enabled && mapper && !blank;
+	chrSlots = direct ? mapper->getChrSlots() : nullptr;
+	nametables = direct ? mapper->getNametables() : nullptr;
+}
+
+const uint32_t* Cart::getChrVersions() {
+	if (mapper && !blank)
+		return mapper->getChrVersions();
+	return nullptr;
+}
+
+void Cart::saveState(StateWriter& state) {
+	if (!mapper || blank) return;
+	if (chrRam)
+		state.writeBytes(chr, chrSize);
+	mapper->saveState(state);
+}
+
+void Cart::loadState(StateReader& state) {
+	if (!mapper || blank) return;
+	if (chrRam)
+		state.readBytes(chr, chrSize);
+	mapper->loadState(state);
+	mapper->chrChanged(0x0000, 0x2000);
+}
+
+void Cart::connectBus(Bus* bus) {
+	if (mapper && !blank)
+		mapper->connectBus(bus);
+}
+
+void Cart::disconnectBus() {
+	if (mapper)
+		mapper->disconnectBus();
+}
+
+void Cart::connectCPU(CPU* cpu) {
+	if (mapper && !blank)
+		mapper->connectCPU(cpu);
+}
+
+void Cart::disconnectCPU() {
+	if (mapper)
+		mapper->disconnectCPU();
+}
+
 void Cart::pickMapper(int mapperID) {
 	switch (mapperID) {
 		case 0:
@@ -136,9 +267,24 @@ void Cart::pickMapper(int mapperID) {
 		case 1:
 			mapper = new MMC1(this);
 			break;
+		case 2:
+			mapper = new UxROM(this);
+			break;
+		case 3:
+			mapper = new CNROM(this);
+			break;
+		case 4:
+			mapper = new MMC3(this);
+			break;
 		case 7:
 			mapper = new AxROM(this);
 			break;
+		case 11:
+			mapper = new ColorDreams(this);
+			break;
+		case 66:
+			mapper = new GxROM(this);
+			break;
 		default:
 			loadStatus = LOAD_UNSUPPORTED_MAPPER;
 			blank = true;
@@ -2,8 +2,16 @@
 #include "cart.hpp"
 #include "ppu.hpp"
 
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 Composite::Composite() {
-	
+	// start from a black screen so headless frame hashes are deterministic
+	for (int i = 0; i < 256 * 240; i++) frameBuffer[i] = 0xFF000000;
+	memset(behindLine, 0, sizeof(behindLine));
 }
 
 
@@ -11,178 +19,124 @@ Composite::Composite() {
 
 
 
-void Composite::renderScanline(int scanline) {
+bool Composite::renderScanline(int scanline) {
 	int pixel = scanline * 256; // not << 8 in case of negative scanlines
 
 	// overscan lines (not visible)
 	if (scanline < 0 || scanline >= 240) {
-		return;
+		return false;
 	}
-	
-	// actual bg color
-	uint32_t bgColorIdx = ppu->palette[0] & 0x3F; // get background color index from palette
-	uint32_t bgColor = defaultARGBpal[bgColorIdx]; // get ARGB color from palette
 
-	for (int x = 0; x < 256; x++) { // fill line with bg color
-		frameBuffer[pixel + x] = bgColor;
-	}
+	// pick up chr ram writes and bank switches since the last fetch
+	ppu->tiles.sync();
 
-	// back priority sprites
-	uint32_t spriteBackLine[256] = {0};
-	if (ppu->MASKshowSprites())
-		renderSpritesAtLine(scanline, 1, spriteBackLine);
-	// render background tiles
-	uint32_t bgLine[256] = {0};
-	if (ppu->MASKshowBackground())
-		renderBackgroundAtLine(scanline, bgLine);
-	// front priority sprites
-	uint32_t spriteFrontLine[256] = {0};
+	// everything is drawn as palette indices and only turned into colors once.
+	// the ppu drew the background while the line ran
+	memset(spriteLine, 0, sizeof(spriteLine));
 	if (ppu->MASKshowSprites())
-		renderSpritesAtLine(scanline, 0, spriteFrontLine);
+		renderSpritesAtLine(spriteLine, behindLine);
 
-	// composite bg and sprites onto frame buffer
+	mergeLine(ppu->bgLine, spriteLine, behindLine, mergedLine);
+
+	// index 0 is the backdrop, transparent pixels of both layers end up there
+	uint32_t colors[32];
+	for (int i = 0; i < 32; i++) {
+		colors[i] = defaultARGBpal[ppu->palette[i] & 0x3F];
+	}
+
+	uint32_t* out = frameBuffer + pixel;
 	for (int x = 0; x < 256; x++) {
-		// if sprite pixel is not transparent, draw it over bg
-		if ((spriteFrontLine[x] & 0xFF000000) != 0) {
-			frameBuffer[pixel + x] = spriteFrontLine[x];
-		} else if ((bgLine[x] & 0xFF000000) != 0) {
-			frameBuffer[pixel + x] = bgLine[x];
-		} else if ((spriteBackLine[x] & 0xFF000000) != 0) {
-			frameBuffer[pixel + x] = spriteBackLine[x];
-		}
+		out[x] = colors[mergedLine[x]];
 	}
-}
 
-void Composite::renderBackgroundAtLine(int scanline, uint32_t* lineBuf) {
-	int scrollX = ppu->SCRLget().x | (ppu->ctrl.raw & 1) * 256;
-	int scrollY = ppu->SCRLget().y | (ppu->ctrl.raw & 2) * 128;
-	// render all 4 nametables to handle scrolling
-	// mirroring is handled in PPU nametable read/write functions
-	// nametables are laid out in a 2x2 grid at fixed positions
-	// we scroll the screen over them, but here we just move them under the screen
-
-	int ntlx = scrollX > 256 ? 512 - scrollX : -scrollX;
-	int ntty = scrollY > 240 ? 496 - scrollY : -scrollY;
-
-	renderNametableAtLine(scanline, 0, ntlx,       ntty,       lineBuf);
-	renderNametableAtLine(scanline, 1, 256 - scrollX, ntty,       lineBuf);
-	renderNametableAtLine(scanline, 2, ntlx,       ntty + 240, lineBuf);
-	renderNametableAtLine(scanline, 3, 256 - scrollX, ntty + 240, lineBuf);
+	return sprite0Hit();
 }
 
-void Composite::renderNametableAtLine(int scanline, int nametableIdx, int xPos, int yPos, uint32_t* lineBuf) {
-	int lineInNametable = scanline - yPos;
-	if (lineInNametable < -240) lineInNametable += 480;
-	if (lineInNametable < 0 || lineInNametable >= 240) {
-		return; // line not in this nametable
-	}
-	if (xPos >= 256 || xPos + 255 < 0) {
-		return; // nametable not visible on screen
+bool Composite::sprite0Hit() {
+	const PPU::SpriteLine& sprites = ppu->spriteLine;
+	if (!sprites.hasSprite0 || !ppu->MASKshowBackground() || !ppu->MASKshowSprites()) {
+		return false;
 	}
-	int nametableBaseAddr = 0x2000 + nametableIdx * 0x400;
-	int attributeBaseAddr = nametableBaseAddr + 0x3C0;
-
-	// Wrap lineInNametable for vertical scrolling
-	int wrappedLine = lineInNametable % 240;
-	int tileRowOffset = wrappedLine / 8 * 32;
-	int tileYInRow = wrappedLine % 8;
-
-	for (int tileCol = 0; tileCol < 32; tileCol++) {
-		int tileXPos = xPos + tileCol * 8;
-		if (tileXPos >= 256 || tileXPos + 7 < 0) {
-			continue; // tile not visible on screen
-		}
-
-		uint8_t tileIdx = ppu->readNametable(nametableBaseAddr + tileRowOffset + tileCol);
-
-		// get attribute byte
-		int attrRow = (wrappedLine / 32);
-		int attrCol = (tileCol / 4);
-		uint8_t attributeByte = ppu->readNametable(attributeBaseAddr + attrRow * 8 + attrCol);
-
-		// determine which quadrant of the attribute byte to use
-		int quadrant = ((wrappedLine % 32) / 16) * 2 + ((tileCol % 4) / 2);
-		uint8_t paletteIndex = (attributeByte >> (quadrant * 2)) & 0x03;
-
-		// get the full tile data from CHR ROM/RAM
-		// each tile is 16 bytes. the first 8 bytes are the low bits of each pixel row,
-		// and the next 8 bytes are the high bits of each pixel row.
-		// 2 bits per pixel, a bit from each byte, so 2 bytes per row:
-		// (08)(08)(08)(08)(08)(08)(08)(08)
-		// (19)(19)(19)(19)(19)(19)(19)(19)
-		// (2A)(2A)(2A)(2A)(2A)(2A)(2A)(2A)
-		// (3B)(3B)(3B)(3B)(3B)(3B)(3B)(3B)
-		// etc...
-
-		uint8_t highByte = cart->readChr(ppu->CTRLbackgroundPatternTableAddress() | tileIdx * 16 + tileYInRow);
-		uint8_t lowByte  = cart->readChr(ppu->CTRLbackgroundPatternTableAddress() | tileIdx * 16 + tileYInRow + 8);
 
-		for (int x = 0; x < 8; x++) {
-			int bit = 7 - x;
-			uint8_t bit0 = (highByte >> bit) & 0x01;
-			uint8_t bit1 = (lowByte >> bit) & 0x01;
-			uint8_t colorIdx = (bit1 << 1) | bit0;
-
-			if (tileXPos + x < 0 || tileXPos + x >= 256) continue; // pixel out of bounds
-			if (colorIdx == 0) {
-				// transparent pixel, do nothing
-			} else {
-				uint8_t absPaletteIndex = ppu->palette[paletteIndex * 4 + colorIdx] & 0x3F; // get color index from palette
-				lineBuf[tileXPos + x] = defaultARGBpal[absPaletteIndex]; // get ARGB color from palette
-			}
-		}
+	const PPU::SpriteLine::Entry& sprite = sprites.sprites[0];
+	const uint8_t* row = ppu->tiles.getRow(sprite.patternAddr, sprite.row, sprite.attr & 0x40);
+	// the left 8 pixels only count when neither layer is clipped there
+	int left = ppu->MASKshowBackgroundLeft() && ppu->MASKshowSpritesLeft() ? 0 : 8;
+	for (int x = 0; x < 8; x++) {
+		int screenX = sprite.x + x;
+		if (screenX < left) continue;
+		if (screenX >= 255) break; // never on the last pixel
+		if (row[x] && ppu->bgLine[screenX]) return true;
 	}
+	return false;
 }
 
-void Composite::renderSpritesAtLine(int scanline, int priority, uint32_t* lineBuf) {
-	for (int s = 63; s >= 0; s--) { // 0 rendered on top
-		if (((ppu->oam.sprites[s].attr & 0x20) >> 5) != priority) {
-			continue; // skip sprites that don't match the priority
-		}
-
-		int spriteY = ppu->oam.sprites[s].y + 1;
-
-		int y = scanline - spriteY;
-		if (y < 0 || y >= 8) continue; // tile not on this line
-	
-		int spriteX = ppu->oam.sprites[s].x;
-		int spriteIdx = ppu->oam.sprites[s].tileIdx;
-		uint8_t attributes = ppu->oam.sprites[s].attr;
+void Composite::mergeLineScalar(const uint8_t* bg, const uint8_t* sprite, const uint8_t* behind, uint8_t* out) {
+	for (int x = 0; x < 256; x++) {
+		// a sprite pixel shows unless it is behind an opaque background pixel
+		bool showSprite = sprite[x] && !(behind[x] && bg[x]);
+		out[x] = showSprite ? sprite[x] : bg[x];
+	}
+}
 
-		bool flipX = (attributes & 0x40) != 0;
-		bool flipY = (attributes & 0x80) != 0;
-		uint8_t paletteIndex = (attributes & 0x03) + 4; // sprite palettes start at index 4
+void Composite::mergeLine(const uint8_t* bg, const uint8_t* sprite, const uint8_t* behind, uint8_t* out) {
+#if defined(__AVX2__)
+	const __m256i zero = _mm256_setzero_si256();
+	for (int x = 0; x < 256; x += 32) {
+		__m256i b = _mm256_loadu_si256((const __m256i*)(bg + x));
+		__m256i s = _mm256_loadu_si256((const __m256i*)(sprite + x));
+		__m256i p = _mm256_loadu_si256((const __m256i*)(behind + x));
+		// hidden = behind & bg opaque, sprite wins where it is opaque and not hidden
+		__m256i bgClear = _mm256_cmpeq_epi8(b, zero);
+		__m256i spClear = _mm256_cmpeq_epi8(s, zero);
+		__m256i hidden = _mm256_andnot_si256(bgClear, p);
+		__m256i useBg = _mm256_or_si256(spClear, hidden);
+		_mm256_storeu_si256((__m256i*)(out + x), _mm256_blendv_epi8(s, b, useBg));
+	}
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (int x = 0; x < 256; x += 16) {
+		__m128i b = _mm_loadu_si128((const __m128i*)(bg + x));
+		__m128i s = _mm_loadu_si128((const __m128i*)(sprite + x));
+		__m128i p = _mm_loadu_si128((const __m128i*)(behind + x));
+		__m128i bgClear = _mm_cmpeq_epi8(b, zero);
+		__m128i spClear = _mm_cmpeq_epi8(s, zero);
+		__m128i hidden = _mm_andnot_si128(bgClear, p);
+		__m128i useBg = _mm_or_si128(spClear, hidden);
+		// no blendv before sse4.1
+		_mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_and_si128(useBg, b), _mm_andnot_si128(useBg, s)));
+	}
+#else
+	mergeLineScalar(bg, sprite, behind, out);
+#endif
+}
 
-		// get the full tile data from CHR ROM/RAM
-		// each tile is 16 bytes. the first 8 bytes are the low bits of each pixel row,
-		// and the next 8 bytes are the high bits of each pixel row.
-		// 2 bits per pixel, a bit from each byte, so 2 bytes per row:
-		// (08)(08)(08)(08)(08)(08)(08)(08)
-		// (19)(19)(19)(19)(19)(19)(19)(19)
-		// (2A)(2A)(2A)(2A)(2A)(2A)(2A)(2A)
-		// (3B)(3B)(3B)(3B)(3B)(3B)(3B)(3B)
-		// etc...
+void Composite::renderSpritesAtLine(uint8_t* lineBuf, uint8_t* behindBuf) {
+	// the ppu already picked this line's sprites
+	const PPU::SpriteLine& sprites = ppu->spriteLine;
+	for (int s = sprites.count - 1; s >= 0; s--) { // first one rendered on top
+		const PPU::SpriteLine::Entry& sprite = sprites.sprites[s];
+		int spriteX = sprite.x;
 
-		// we only need one row (2 bytes) at a time
-		uint8_t highByte, lowByte;
+		bool flipX = (sprite.attr & 0x40) != 0;
+		uint8_t behind = (sprite.attr & 0x20) ? 0xFF : 0x00;
+		uint8_t paletteIndex = (sprite.attr & 0x03) + 4; // sprite palettes start at index 4
 
-		int row = flipY ? (7 - y) : y;
-		highByte = cart->readChr(ppu->CTRLspritePatternTableAddress() | spriteIdx * 16 + row);
-		lowByte  = cart->readChr(ppu->CTRLspritePatternTableAddress() | spriteIdx * 16 + row + 8);
+		// pre-decoded row, the flipped copy is already mirrored
+		const uint8_t* row = ppu->tiles.getRow(sprite.patternAddr, sprite.row, flipX);
 
 		for (int x = 0; x < 8; x++) {
-			int bit = flipX ? x : (7 - x);
-			uint8_t bit0 = (highByte >> bit) & 0x01;
-			uint8_t bit1 = (lowByte >> bit) & 0x01;
-			uint8_t colorIdx = (bit1 << 1) | bit0;
+			uint8_t colorIdx = row[x];
 
-			if (spriteX + x < 0 || spriteX + x >= 256) continue; // pixel out of bounds
+			if (spriteX + x >= 256) break; // pixel out of bounds
 
 			if (colorIdx == 0) {
 				// transparent pixel, do nothing
 			} else {
-				uint8_t absPaletteIndex = ppu->palette[paletteIndex * 4 + colorIdx] & 0x3F; // get color index from palette
-				lineBuf[spriteX + x] = defaultARGBpal[absPaletteIndex]; // get ARGB color from palette
+				// the frontmost opaque sprite decides the priority too, so a
+				// behind sprite can hide a later sprite that is in front
+				lineBuf[spriteX + x] = paletteIndex * 4 + colorIdx;
+				behindBuf[spriteX + x] = behind;
 			}
 		}
 	}
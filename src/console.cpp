@@ -0,0 +1,140 @@
+#include "console.hpp"
+#include "mappers/mapper.hpp"
+
+
+Console::Console() {
+	cpu.connectBus(&bus);
+	apu.connectBus(&bus);
+	apu.connectCPU(&cpu);
+	bus.connectAPU(&apu);
+	bus.connectPPU(&ppu);
+	ppu.connectComposite(&comp);
+	ppu.connectCPU(&cpu);
+	comp.connectPPU(&ppu);
+	bus.connectController1(&controller1);
+	bus.connectController2(&controller2);
+}
+
+std::unique_ptr<Console> Console::create(Cart* cart) {
+	std::unique_ptr<Console> console(new Console());
+	console->connectCart(cart);
+	console->setController1(STANDARD);
+	console->fullReset();
+	return console;
+}
+
+void Console::reset() {
+	apu.reset();
+	cpu.reset();
+	if (cart)
+		if (cart->mapper)
+			cart->mapper->reset();
+}
+
+void Console::powerOn() {
+	apu.reset();
+	cpu.powerOn();
+}
+
+void Console::fullReset() {
+	apu.reset();
+	cpu.powerOn();
+	cpu.reset();
+}
+
+CPU::RunResult Console::stepFrame() {
+	// no budget, the frame end (or a jam or a breakpoint) stops the cpu
+	CPU::RunResult result = cpu.run(INT64_MAX);
+	if (result != CPU::RUN_BREAKPOINT) apu.endFrame();
+	return result;
+}
+
+uint64_t Console::frameHash() {
+	return fnv1a((const uint8_t*)comp.getBuffer(), 256 * 240 * sizeof(uint32_t));
+}
+
+void Console::writeState(StateWriter& state) {
+	state.write(SAVESTATE_MAGIC);
+	state.write(SAVESTATE_VERSION);
+	int32_t mapperID = cart && !cart->blank ? cart->mapperID : -1;
+	state.write(mapperID);
+
+	cpu.saveState(state);
+	bus.saveState(state);
+	ppu.saveState(state);
+	apu.saveState(state);
+	controller1.saveState(state);
+	controller2.saveState(state);
+	if (cart) cart->saveState(state);
+}
+
+size_t Console::stateSize() {
+	StateWriter counter;
+	writeState(counter);
+	return counter.size();
+}
+
+size_t Console::saveState(uint8_t* data, size_t capacity) {
+	if (!data) return 0;
+	StateWriter state(data, capacity);
+	writeState(state);
+	return state.ok() ? state.size() : 0;
+}
+
+bool Console::loadState(const uint8_t* data, size_t size) {
+	// check everything before touching the hardware so a bad state can't
+	// leave the console half loaded
+	if (size != stateSize()) return false;
+
+	StateReader state(data, size);
+	uint32_t magic, version;
+	int32_t mapperID;
+	state.read(magic);
+	state.read(version);
+	state.read(mapperID);
+	if (magic != SAVESTATE_MAGIC || version != SAVESTATE_VERSION) return false;
+	if (mapperID != (cart && !cart->blank ? cart->mapperID : -1)) return false;
+
+	cpu.loadState(state);
+	bus.loadState(state);
+	ppu.loadState(state);
+	apu.loadState(state);
+	controller1.loadState(state);
+	controller2.loadState(state);
+	if (cart) cart->loadState(state);
+	return state.ok();
+}
+
+void Console::connectCart(Cart* cart) {
+	if (this->cart) this->cart->disconnectCPU();
+	this->cart = cart;
+	if (cart) cart->connectCPU(&cpu);
+	bus.connectCart(cart);
+	comp.connectCart(cart);
+	ppu.connectCart(cart);
+}
+
+void Console::disconnectCart() {
+	if (cart) cart->disconnectCPU();
+	this->cart = nullptr;
+	bus.disconnectCart();
+	comp.disconnectCart();
+	ppu.disconnectCart();
+}
+
+void Console::setController1(ControllerType type) {
+	controller1 = Controller(type);
+}
+
+void Console::setController2(ControllerType type) {
+	controller2 = Controller(type);
+}
+
+uint64_t fnv1a(const uint8_t* data, size_t size) {
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
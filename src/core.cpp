@@ -2,69 +2,62 @@
 
 
 Core::Core() {
-	cpu.connectBus(&bus);
-	bus.connectAPU(&apu);
-	bus.connectPPU(&ppu);
-	ppu.connectComposite(&comp);
-	ppu.connectCPU(&cpu);
-	comp.connectPPU(&ppu);
-	bus.connectController1(&controller1);
-	bus.connectController2(&controller2);
+	headerDatabase.load("headerdb.txt");
 }
 
 void Core::run() {
-	if (enableWindow) {
-		if (window.StartWindow() != 0) {
-			std::cerr << "Failed to start window!" << std::endl;
-			return;
-		}
-		
+	// without a window there is nothing to run for, the headless runner
+	// drives a Console directly
+	if (window.StartWindow() != 0) {
+		std::cerr << "Failed to start window!" << std::endl;
+		return;
 	}
+	// no sound is not worth stopping over
+	window.initAudio(apu.getSampleRate(), audioLatency);
+
+	fullReset();
 
-	cpu.powerOn();
-	cpu.reset();
 	while (true) {
-		if (paused || emulationSpeed == 0.0) {
-			// paused
-			if (!passFrame) {
-				SDL_Delay(100);
-				uint32_t* frameBuffer = comp.getBuffer();
-				if (frameBuffer) {
-					window.drawBuffer(frameBuffer);
-				}
-				handleWindowEvents();
-				window.updateSurface(1.0);
-			}
-		}
-		if (cpu.clock()) { // returns true if frame has completed
+		if ((paused || emulationSpeed == 0.0) && !passFrame) {
+			SDL_Delay(100);
 			uint32_t* frameBuffer = comp.getBuffer();
 			if (frameBuffer) {
 				window.drawBuffer(frameBuffer);
 			}
-			std::vector<uint8_t> audioBuffer = apu.getAudioBuffer();
-			window.queueAudio(&audioBuffer);
 			handleWindowEvents();
-			// 9999 to skip delay when advancing a single frame
-			window.updateSurface(passFrame ? 9999 : emulationSpeed);
-			passFrame = false;
+			window.updateSurface(1.0);
+			continue;
 		}
-	}
-}
-
-void Core::reset() {
-	cpu.reset();
-	if (cart)
-		if (cart->mapper)
-			cart->mapper->reset();
-}
 
-void Core::powerOn() {
-	cpu.powerOn();
-}
+		// the whole frame runs in one go, only a breakpoint stops it early
+		CPU::RunResult result = cpu.run(INT64_MAX);
+		if (result == CPU::RUN_BREAKPOINT) {
+			paused = true;
+			passFrame = false;
+			std::ostringstream oss;
+			oss << "Breakpoint at 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << cpu.getPC();
+			addMessage(oss.str(), 0xFFFFFF00);
+			continue;
+		}
 
-void Core::fullReset() {
-	cpu.powerOn();
-	cpu.reset();
+		// a frame is done (or the cpu is jammed and the screen just holds)
+		if (enableRewind) {
+			// the frame that just ran is what gets shown, then jump back past it
+			if (rewinding) rewind.stepBack(*this);
+			else rewind.push(*this);
+		}
+		uint32_t* frameBuffer = comp.getBuffer();
+		if (frameBuffer) {
+			window.drawBuffer(frameBuffer);
+		}
+		apu.endFrame();
+		window.queueAudio(apu.getSamples(), apu.getSampleCount());
+		updateRateControl();
+		handleWindowEvents();
+		// 9999 to skip delay when advancing a single frame
+		window.updateSurface(passFrame ? 9999 : emulationSpeed);
+		passFrame = false;
+	}
 }
 
 void Core::handleWindowEvents() {
@@ -167,6 +160,7 @@ void Core::handleKeyboardEvent(SDL_KeyboardEvent keyEvent) {
 				addMessage("K - Toggle CPU killed state", 0xFFFFFF00);
 				addMessage("G - Randomize 100 Bytes in Memory", 0xFFFFFF00);
 				addMessage(". - Sprint while held", 0xFFFFFF00);
+				addMessage("Backspace - Rewind while held", 0xFFFFFF00);
 				addMessage("+ - Increase Emulation Speed", 0xFFFFFF00);
 				addMessage("- - Decrease Emulation Speed", 0xFFFFFF00);
 				addMessage("; - Command line mode", 0xFFFFFF00); 
@@ -178,6 +172,9 @@ void Core::handleKeyboardEvent(SDL_KeyboardEvent keyEvent) {
 				parseCommand(input);
 			}
 			break;
+		case SDLK_BACKSPACE: // rewind while held
+			rewinding = keyEvent.type == SDL_KEYDOWN;
+			break;
 		case SDLK_PERIOD:
 			if (pressed) {
 				prevEmulationSpeed = emulationSpeed;
@@ -409,6 +406,18 @@ void Core::parseCommand(std::string command) {
 			}
 			commandLoadROM(filename);
 		}
+	} else if (tokens[0] == "savestate") {
+		commandSaveState();
+	} else if (tokens[0] == "loadstate") {
+		commandLoadState();
+	} else if (tokens[0] == "audio") {
+		commandAudioStats();
+	} else if (tokens[0] == "pacing") {
+		if (tokens.size() == 2) {
+			commandSetPacing(tokens[1]);
+		} else {
+			addMessage("Usage: pacing <audio|timer>", 0xFFFFFF00);
+		}
 	} else if (tokens[0] == "randomize") {
 		if (tokens.size() == 2) {
 			try {
@@ -422,16 +431,18 @@ void Core::parseCommand(std::string command) {
 			addMessage("Usage: randomize <bytes>", 0xFFFFFF00);
 		}
 	} else if (tokens[0] == "cheat") {
-		if (tokens.size() == 3) {
+		if (tokens.size() == 3 || tokens.size() == 4) {
 			try {
 				unsigned long a = std::stoul(tokens[1], nullptr, 0);
 				unsigned long v = std::stoul(tokens[2], nullptr, 0);
 				uint16_t addr = a & 0xFFFF;
 				uint8_t value = v & 0xFF;
-				addCheat(addr, value);
+				int compare = tokens.size() == 4 ? std::stoul(tokens[3], nullptr, 0) & 0xFF : -1;
+				addCheat(addr, value, compare);
 				std::ostringstream oss;
 				oss << "Cheat at 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr
-					<< " set to 0x" << std::setw(2) << value;
+					<< " set to 0x" << std::setw(2) << static_cast<int>(value);
+				if (compare >= 0) oss << " if 0x" << std::setw(2) << compare;
 				addMessage(oss.str(), 0xFFFFFF00);
 			} catch (...) {
 				addMessage("Invalid address or value for cheat", 0xFFFF0000);
@@ -443,10 +454,11 @@ void Core::parseCommand(std::string command) {
 		}
 	} else if (tokens[0] == "cheats") {
 		if (tokens.size() == 1) {
-			for (std::pair<uint16_t, uint8_t> cheat : bus.cheats) {
+			for (const Cheat& cheat : bus.getCheats()) {
 				std::ostringstream oss;
-				oss << std::hex << std::uppercase << std::setfill('0') << std::setw(4)
-					<< "0x" << cheat.first << " = 0x" << std::setw(2) << cheat.second;
+				oss << std::hex << std::uppercase << std::setfill('0')
+					<< "0x" << std::setw(4) << cheat.addr << " = 0x" << std::setw(2) << static_cast<int>(cheat.value);
+				if (cheat.compare >= 0) oss << " if 0x" << std::setw(2) << cheat.compare;
 				addMessage(oss.str(), 0xFFFFFF00);
 			}
 		}
@@ -455,14 +467,51 @@ void Core::parseCommand(std::string command) {
 			try {
 				unsigned long a = std::stoul(tokens[1], nullptr, 0);
 				uint16_t addr = a & 0xFFFF;
-				bus.cheats.erase(addr);
 				std::ostringstream oss;
-				oss << "removed cheat at 0x" << std::hex << std::uppercase
-					<< std::setfill('0') << std::setw(4) << addr;
+				if (bus.removeCheat(addr)) {
+					oss << "removed cheat at 0x";
+				} else {
+					oss << "no cheat at 0x";
+				}
+				oss << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr;
+				addMessage(oss.str(), 0xFFFFFF00);
 			} catch (...) {
 				addMessage("Invalid address or value for setmem", 0xFFFF0000);
 			}
 		}
+	} else if (tokens[0] == "break") {
+		if (tokens.size() == 2) {
+			try {
+				uint16_t addr = std::stoul(tokens[1], nullptr, 0) & 0xFFFF;
+				cpu.addBreakpoint(addr);
+				std::ostringstream oss;
+				oss << "Breakpoint at 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr;
+				addMessage(oss.str(), 0xFFFFFF00);
+			} catch (...) {
+				addMessage("Invalid address for break", 0xFFFF0000);
+			}
+		} else {
+			for (uint16_t addr : cpu.getBreakpoints()) {
+				std::ostringstream oss;
+				oss << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr;
+				addMessage(oss.str(), 0xFFFFFF00);
+			}
+		}
+	} else if (tokens[0] == "rmbreak") {
+		if (tokens.size() == 2) {
+			try {
+				uint16_t addr = std::stoul(tokens[1], nullptr, 0) & 0xFFFF;
+				std::ostringstream oss;
+				oss << (cpu.removeBreakpoint(addr) ? "removed breakpoint at 0x" : "no breakpoint at 0x")
+					<< std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr;
+				addMessage(oss.str(), 0xFFFFFF00);
+			} catch (...) {
+				addMessage("Invalid address for rmbreak", 0xFFFF0000);
+			}
+		} else {
+			cpu.clearBreakpoints();
+			addMessage("Breakpoints cleared", 0xFFFFFF00);
+		}
 	} else if (tokens[0] == "help") {
 		addMessage("available commands:", 0xFFFFFF00);
 		addMessage("reset - reset the rom", 0xFFFFFF00);
@@ -473,10 +522,16 @@ void Core::parseCommand(std::string command) {
 		addMessage("setmem <addr> <value> - set memory", 0xFFFFFF00);
 		addMessage("getmem <addr> - get memory at address", 0xFFFFFF00);
 		addMessage("loadrom <filename> - load ROM from file", 0xFFFFFF00);
-		addMessage("cheat <addr> <value> - set a cheat", 0xFFFFFF00);
-		addMessage("ggcheat <code> - set a game genie cheat", 0xFFFFFF00);
+		addMessage("savestate - save to the quick slot", 0xFFFFFF00);
+		addMessage("loadstate - load from the quick slot", 0xFFFFFF00);
+		addMessage("audio - show audio buffer stats", 0xFFFFFF00);
+		addMessage("pacing <audio|timer> - let the audio buffer steer the rate", 0xFFFFFF00);
+		addMessage("cheat <addr> <value> [compare] - set a cheat", 0xFFFFFF00);
+		addMessage("ggcheat <code> - set a 6 or 8 letter game genie cheat", 0xFFFFFF00);
 		addMessage("cheats - list all cheats", 0xFFFFFF00);
 		addMessage("rmcheat <addr> - removes a cheat by addr", 0xFFFFFF00);
+		addMessage("break [addr] - pause before pc reaches addr / list them", 0xFFFFFF00);
+		addMessage("rmbreak [addr] - remove a breakpoint / all of them", 0xFFFFFF00);
 	} else {
 		addMessage("Unknown command: " + tokens[0], 0xFFFF0000);
 	}
@@ -524,7 +579,7 @@ void Core::commandSetSpeed(double speed) {
 
 void Core::commandLoadROM(std::string filename) {
 	// load ROM from filename
-	Cart* newCart = new Cart(filename);
+	Cart* newCart = new Cart(filename, &headerDatabase);
 	if (newCart->loadStatus != Cart::LOAD_SUCCESS) {
 		switch (newCart->loadStatus) {
 			case Cart::LOAD_FILE_NOT_FOUND:
@@ -554,6 +609,68 @@ void Core::commandLoadROM(std::string filename) {
 	// dont reset, leave that to user
 }
 
+void Core::commandSaveState() {
+	size_t size = stateSize();
+	if (quickState.size() < size) quickState.resize(size);
+	quickStateSize = saveState(quickState.data(), quickState.size());
+	if (quickStateSize) {
+		addMessage("State saved", 0xFF00FF00);
+	} else {
+		addMessage("Failed to save state", 0xFFFF0000);
+	}
+}
+
+void Core::commandLoadState() {
+	if (!quickStateSize) {
+		addMessage("No saved state", 0xFFFF0000);
+	} else if (loadState(quickState.data(), quickStateSize)) {
+		addMessage("State loaded", 0xFF00FF00);
+	} else {
+		addMessage("Saved state doesn't match this ROM", 0xFFFF0000);
+	}
+}
+
+void Core::commandAudioStats() {
+	Window::AudioStats stats = window.getAudioStats();
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(1) << "Audio queued " << stats.queuedMs << "/" << stats.targetMs
+		<< " ms, " << stats.underruns << " underruns, " << stats.overruns << " samples dropped";
+	addMessage(oss.str(), 0xFFFFFF00);
+}
+
+void Core::commandSetPacing(std::string mode) {
+	if (mode == "audio") {
+		pacing = Pacing::AUDIO;
+	} else if (mode == "timer") {
+		pacing = Pacing::TIMER;
+		apu.setRateAdjust(1.0);
+	} else {
+		addMessage("Unknown pacing mode: " + mode, 0xFFFF0000);
+		return;
+	}
+	addMessage("Pacing: " + mode, 0xFFFFFF00);
+}
+
+void Core::updateRateControl() {
+	Window::AudioStats stats = window.getAudioStats();
+	if (pacing != Pacing::AUDIO || emulationSpeed != 1.0 || stats.targetMs <= 0) {
+		apu.setRateAdjust(1.0);
+		return;
+	}
+	// an empty queue asks for +0.5% samples a frame, a full one (twice the
+	// target) for -0.5%. the step is far below what anyone can hear as pitch
+	double offset = (stats.targetMs - stats.queuedMs) / stats.targetMs;
+	offset = std::max(-1.0, std::min(1.0, offset));
+	apu.setRateAdjust(1.0 + offset * MAX_RATE_ADJUST);
+
+	// frames follow the queue as well: more queued than the target holds
+	// the next one back, less lets it come early. the cap keeps a burst
+	// (a stall, a menu) from showing up as a visible hitch
+	double shiftMs = (stats.queuedMs - stats.targetMs) * FRAME_SHIFT_GAIN;
+	shiftMs = std::max(-MAX_FRAME_SHIFT_MS, std::min(MAX_FRAME_SHIFT_MS, shiftMs));
+	window.shiftFrameDeadline(shiftMs);
+}
+
 uint8_t Core::gGCharToHex(char c) {
 	c = toupper(c);
     switch (c) {
@@ -578,61 +695,69 @@ uint8_t Core::gGCharToHex(char c) {
 }
 
 void Core::addGameGenieCheat(std::string cheatCode) {
-    if (cheatCode.length() != 6) {
-        addMessage("Code must be 6 characters!", 0xFFFF0000);
-        return;
-    }
+	if (cheatCode.length() != 6 && cheatCode.length() != 8) {
+		addMessage("Code must be 6 or 8 characters!", 0xFFFF0000);
+		return;
+	}
 
-    // Convert string characters to their 4-bit integer values (C0 through C5)
-    uint8_t C0 = gGCharToHex(cheatCode[0]);
-    uint8_t C1 = gGCharToHex(cheatCode[1]);
-    uint8_t C2 = gGCharToHex(cheatCode[2]);
-    uint8_t C3 = gGCharToHex(cheatCode[3]);
-    uint8_t C4 = gGCharToHex(cheatCode[4]);
-    uint8_t C5 = gGCharToHex(cheatCode[5]);
-
-    if (C0 == 0xFF || C1 == 0xFF || C2 == 0xFF ||
-        C3 == 0xFF || C4 == 0xFF || C5 == 0xFF) {
-        addMessage("Invalid code!", 0xFFFF0000);
-        return;
-    }
+	// Convert string characters to their 4-bit integer values (C0 through C7)
+	uint8_t C[8] = {0};
+	for (size_t i = 0; i < cheatCode.length(); i++) {
+		C[i] = gGCharToHex(cheatCode[i]);
+		if (C[i] == 0xFF) {
+			addMessage("Invalid code!", 0xFFFF0000);
+			return;
+		}
+	}
 
-    // Decode the Address (15-bit value starting at 0x8000)
-    // Formula: 0x8000 + ((C3&7)<<12) | ((C5&7)<<8) | ((C4&8)<<8) | ((C2&7)<<4) | ((C1&8)<<4) | (C4&7) | (C3&8)
-    uint16_t addr = 0x8000 |
-        ((C3 & 7) << 12) |
-        ((C5 & 7) << 8)  |
-        ((C4 & 8) << 8)  |
-        ((C2 & 7) << 4)  |
-        ((C1 & 8) << 4)  |
-        (C4 & 7)         |
-        (C3 & 8);
-
-    // Decode the Value (8-bit replacement data)
-    // Formula: ((C1&7)<<4) | ((C0&8)<<4) | (C0&7) | (C5&8)
-    uint8_t val =
-        ((C1 & 7) << 4)  |
-        ((C0 & 8) << 4)  |
-        (C0 & 7)         |
-        (C5 & 8);
-
-    addCheat(addr, val);
+	// Decode the Address (15-bit value starting at 0x8000)
+	// Formula: 0x8000 + ((C3&7)<<12) | ((C5&7)<<8) | ((C4&8)<<8) | ((C2&7)<<4) | ((C1&8)<<4) | (C4&7) | (C3&8)
+	uint16_t addr = 0x8000 |
+		((C[3] & 7) << 12) |
+		((C[5] & 7) << 8)  |
+		((C[4] & 8) << 8)  |
+		((C[2] & 7) << 4)  |
+		((C[1] & 8) << 4)  |
+		(C[4] & 7)         |
+		(C[3] & 8);
+
+	// Decode the Value (8-bit replacement data)
+	// Formula: ((C1&7)<<4) | ((C0&8)<<4) | (C0&7) | (C5&8)
+	// 8 letter codes take the last bit from C7 instead, C5 moves to the compare value
+	bool hasCompare = cheatCode.length() == 8;
+	uint8_t val =
+		((C[1] & 7) << 4)  |
+		((C[0] & 8) << 4)  |
+		(C[0] & 7)         |
+		(hasCompare ? (C[7] & 8) : (C[5] & 8));
+
+	// Decode the Compare value (8 letter codes only)
+	// Formula: ((C7&7)<<4) | ((C6&8)<<4) | (C6&7) | (C5&8)
+	int compare = -1;
+	if (hasCompare) {
+		compare =
+			((C[7] & 7) << 4)  |
+			((C[6] & 8) << 4)  |
+			(C[6] & 7)         |
+			(C[5] & 8);
+	}
+
+	addCheat(addr, val, compare);
 	std::ostringstream oss;
 	oss << "Cheat at 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << addr
 		<< " set to 0x" << std::setw(2) << static_cast<int>(val);
+	if (hasCompare) oss << " if 0x" << std::setw(2) << compare;
 	addMessage(oss.str(), 0xFFFFFF00);
 }
 
 
-void Core::addCheat(uint16_t addr, uint8_t val) {
-	bus.cheats[addr] = val;
+void Core::addCheat(uint16_t addr, uint8_t val, int compare) {
+	bus.addCheat(addr, val, compare);
 }
 
 void Core::connectCart(Cart* cart) {
-	this->cart = cart;
-	bus.connectCart(cart);
-	comp.connectCart(cart);
-	ppu.connectCart(cart);
+	Console::connectCart(cart);
+	rewind.clear();
 	if (!cart) {
 
 	} else if (cart->blank) {
@@ -651,25 +776,10 @@ void Core::connectCart(Cart* cart) {
 				break;
 		}
 	} else { // success
-		addMessage("ROM loaded: " + cart->filename, 0xFF00FF00);
+		addMessage("ROM loaded: " + cart->filename + (cart->headerFixed ? " (header corrected)" : ""), 0xFF00FF00);
 	}
 }
 
-void Core::disconnectCart() {
-	this->cart = nullptr;
-	bus.disconnectCart();
-	comp.disconnectCart();
-	ppu.disconnectCart();
-}
-
-void Core::setController1(ControllerType type) {
-	controller1 = Controller(type);
-}
-
-void Core::setController2(ControllerType type) {
-	controller2 = Controller(type);
-}
-
 // tieg
 #include <random>
 
@@ -0,0 +1,210 @@
+// headless batch runner for rom regression runs
+// runs each rom for a fixed number of frames as fast as possible without
+// touching SDL, then prints one JSON line per rom with a frame hash, a ram
+// hash and timing stats
+//
+// usage: nescata-headless [--frames N] [--input file] [--header-db file] rom.nes [rom.nes ...]
+//        nescata-headless --scaling [--instances N] [--frames N] rom.nes
+//        nescata-headless --trace file [--frames N] [--input file] rom.nes
+//        nescata-headless --format-trace file
+//
+// --header-db file loads header corrections (see headerdb.hpp) for every
+// rom. the JSON line carries the rom's crc32, the database key
+//
+// the input file holds one hex controller byte per line, one line per frame
+// (bit order as in StandardControllerState). frames past the end of the file
+// keep the last state
+//
+// --scaling steps N copies of the rom on a ConsolePool with 1 up to all
+// hardware threads and prints the aggregate frame rate for each thread count
+//
+// --trace writes a binary record of every instruction the rom runs to file,
+// --format-trace turns such a file into the text log tests/verif-log.py reads
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "console.hpp"
+#include "pool.hpp"
+#include "trace.hpp"
+
+
+static std::string jsonEscape(const std::string& str) {
+	std::string out;
+	for (char c : str) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+	return out;
+}
+
+static const char* loadStatusName(Cart& cart) {
+	switch (cart.loadStatus) {
+		case Cart::LOAD_SUCCESS:            return "ok";
+		case Cart::LOAD_EMPTY:              return "empty";
+		case Cart::LOAD_FILE_NOT_FOUND:     return "file not found";
+		case Cart::LOAD_INVALID_FORMAT:     return "invalid format";
+		case Cart::LOAD_UNSUPPORTED_MAPPER: return "unsupported mapper";
+	}
+	return "unknown";
+}
+
+static bool loadInput(const char* path, std::vector<uint8_t>& input) {
+	FILE* f = fopen(path, "r");
+	if (!f) return false;
+	unsigned int value;
+	while (fscanf(f, "%x", &value) == 1) {
+		input.push_back(value & 0xFF);
+	}
+	fclose(f);
+	return true;
+}
+
+static bool runRom(const char* path, int frames, const std::vector<uint8_t>& input, const char* tracePath,
+		const HeaderDatabase* database) {
+	Cart cart(path, database);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		printf("{\"rom\":\"%s\",\"status\":\"%s\"}\n", jsonEscape(path).c_str(), loadStatusName(cart));
+		return false;
+	}
+
+	std::unique_ptr<Console> console = Console::create(&cart);
+
+	TraceRecorder trace;
+	if (tracePath) {
+		if (!trace.startFile(tracePath)) {
+			fprintf(stderr, "can't write trace file %s\n", tracePath);
+			return false;
+		}
+		console->cpu.setTrace(&trace);
+	}
+
+	uint8_t buttons = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		if (frame < (int)input.size()) buttons = input[frame];
+		console->controller1.setState(buttons);
+		console->stepFrame();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	console->cpu.setTrace(nullptr);
+	trace.stop();
+
+	uint8_t ram[0x800];
+	for (int i = 0; i < 0x800; i++) {
+		ram[i] = console->bus.read(i);
+	}
+	uint64_t frameHash = console->frameHash();
+	uint64_t ramHash = fnv1a(ram, sizeof(ram));
+
+	printf("{\"rom\":\"%s\",\"status\":\"ok\",\"crc32\":\"%08x\",\"frames\":%d,\"frame_hash\":\"%016llx\",\"ram_hash\":\"%016llx\","
+		"\"cpu_cycles\":%ld,\"seconds\":%.6f,\"fps\":%.1f}\n",
+		jsonEscape(path).c_str(), cart.crc, frames, (unsigned long long)frameHash, (unsigned long long)ramHash,
+		console->cpu.getCycles(), seconds, seconds > 0 ? frames / seconds : 0.0);
+
+	return true;
+}
+
+static bool runScaling(const char* path, int frames, int instances, const HeaderDatabase* database) {
+	int maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads <= 0) maxThreads = 1;
+
+	double baseFps = 0;
+	for (int threadCount = 1; threadCount <= maxThreads; threadCount++) {
+		// fresh consoles for every run so each thread count does the same work
+		// consoles are declared after the carts they point at, so they go first
+		std::vector<std::unique_ptr<Cart>> carts;
+		std::vector<std::unique_ptr<Console>> owned;
+		std::vector<Console*> consoles;
+		for (int i = 0; i < instances; i++) {
+			carts.emplace_back(new Cart(path, database));
+			Cart* cart = carts.back().get();
+			if (cart->loadStatus != Cart::LOAD_SUCCESS) {
+				printf("{\"rom\":\"%s\",\"status\":\"%s\"}\n", jsonEscape(path).c_str(), loadStatusName(*cart));
+				return false;
+			}
+			owned.push_back(Console::create(cart));
+			consoles.push_back(owned.back().get());
+		}
+
+		ConsolePool pool(threadCount);
+		auto start = std::chrono::steady_clock::now();
+		pool.stepFrames(consoles, frames);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double fps = seconds > 0 ? (double)frames * instances / seconds : 0.0;
+		if (threadCount == 1) baseFps = fps;
+		printf("{\"rom\":\"%s\",\"threads\":%d,\"instances\":%d,\"frames\":%d,\"seconds\":%.6f,"
+			"\"fps\":%.1f,\"speedup\":%.2f}\n",
+			jsonEscape(path).c_str(), threadCount, instances, frames, seconds, fps, baseFps > 0 ? fps / baseFps : 0.0);
+		fflush(stdout);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	int frames = 600;
+	int instances = 0;
+	bool scaling = false;
+	const char* tracePath = nullptr;
+	std::vector<uint8_t> input;
+	HeaderDatabase database;
+	std::vector<const char*> roms;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--instances") && i + 1 < argc) {
+			instances = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--scaling")) {
+			scaling = true;
+		} else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+			tracePath = argv[++i];
+		} else if (!strcmp(argv[i], "--format-trace") && i + 1 < argc) {
+			if (!formatTraceFile(argv[++i], stdout)) {
+				fprintf(stderr, "can't read trace file %s\n", argv[i]);
+				return 2;
+			}
+			return 0;
+		} else if (!strcmp(argv[i], "--header-db") && i + 1 < argc) {
+			if (!database.load(argv[++i])) {
+				fprintf(stderr, "can't read header database %s\n", argv[i]);
+				return 2;
+			}
+		} else if (!strcmp(argv[i], "--input") && i + 1 < argc) {
+			if (!loadInput(argv[++i], input)) {
+				fprintf(stderr, "can't read input file %s\n", argv[i]);
+				return 2;
+			}
+		} else {
+			roms.push_back(argv[i]);
+		}
+	}
+
+	if (roms.empty() || (tracePath && roms.size() > 1)) {
+		fprintf(stderr, "usage: %s [--frames N] [--input file] [--header-db file] rom.nes [rom.nes ...]\n", argv[0]);
+		fprintf(stderr, "       %s --scaling [--instances N] [--frames N] rom.nes\n", argv[0]);
+		fprintf(stderr, "       %s --trace file [--frames N] [--input file] rom.nes\n", argv[0]);
+		fprintf(stderr, "       %s --format-trace file\n", argv[0]);
+		return 2;
+	}
+
+	if (scaling) {
+		if (instances <= 0) instances = 4 * std::max(1u, std::thread::hardware_concurrency());
+		return runScaling(roms[0], frames, instances, &database) ? 0 : 1;
+	}
+
+	bool allLoaded = true;
+	for (const char* rom : roms) {
+		allLoaded &= runRom(rom, frames, input, tracePath, &database);
+		fflush(stdout);
+	}
+	return allLoaded ? 0 : 1;
+}
@@ -4,7 +4,7 @@
 
 int main(int argc, char* argv[]) {
 	Core core;
-	Cart cart(argc > 1 ? argv[1] : "");
+	Cart cart(argc > 1 ? argv[1] : "", &core.headerDatabase);
 
 	core.connectCart(&cart);
 	core.setController1(STANDARD);
@@ -0,0 +1,102 @@
+#include "pool.hpp"
+#include "console.hpp"
+
+
+ConsolePool::ConsolePool(int threadCount) {
+	if (threadCount <= 0) {
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount <= 0) threadCount = 1;
+	}
+
+	for (int i = 0; i < threadCount; i++) {
+		workers.emplace_back(new Worker());
+	}
+	for (int i = 0; i < threadCount; i++) {
+		threads.emplace_back(&ConsolePool::workerLoop, this, i);
+	}
+}
+
+ConsolePool::~ConsolePool() {
+	{
+		std::lock_guard<std::mutex> guard(batchLock);
+		stopping = true;
+	}
+	batchStart.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void ConsolePool::stepFrames(const std::vector<Console*>& consoles, int frames) {
+	if (consoles.empty()) return;
+
+	// set up the batch before any task becomes visible to the workers
+	framesPerTask = frames;
+	remaining = consoles.size();
+	for (size_t i = 0; i < consoles.size(); i++) {
+		Worker& worker = *workers[i % workers.size()];
+		std::lock_guard<std::mutex> guard(worker.lock);
+		worker.tasks.push_back(consoles[i]);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(batchLock);
+		batchId++;
+	}
+	batchStart.notify_all();
+
+	std::unique_lock<std::mutex> wait(batchLock);
+	batchDone.wait(wait, [this] { return remaining == 0; });
+}
+
+int ConsolePool::getThreadCount() const {
+	return threads.size();
+}
+
+void ConsolePool::workerLoop(int idx) {
+	uint64_t lastBatch = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> wait(batchLock);
+			batchStart.wait(wait, [&] { return stopping || batchId != lastBatch; });
+			if (stopping) return;
+			lastBatch = batchId;
+		}
+
+		Console* console;
+		while (popTask(idx, console)) {
+			for (int frame = 0; frame < framesPerTask; frame++) {
+				console->stepFrame();
+			}
+			if (--remaining == 0) {
+				std::lock_guard<std::mutex> guard(batchLock);
+				batchDone.notify_all();
+			}
+		}
+	}
+}
+
+bool ConsolePool::popTask(int idx, Console*& console) {
+	// own work first, newest task
+	{
+		Worker& own = *workers[idx];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.tasks.empty()) {
+			console = own.tasks.back();
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// then steal the oldest task from another worker
+	for (size_t i = 1; i < workers.size(); i++) {
+		Worker& victim = *workers[(idx + i) % workers.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			console = victim.tasks.front();
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
@@ -2,6 +2,9 @@
 #include "cart.hpp"
 #include "composite.hpp"
 #include "cpu.hpp"
+#include "savestate.hpp"
+
+#include <cstring>
 
 PPU::PPU() {
 	reset();
@@ -19,50 +22,91 @@ void PPU::reset() {
 	ctrl.raw = 0;
 	mask.raw = 0;
 	stat.raw = 0;
+	v = 0;
+	t = 0;
+	fineX = 0;
 	w = true;
 
+	renderDot = 0;
+	memset(bgTiles, 0, sizeof(bgTiles));
+	memset(bgLine, 0, sizeof(bgLine));
+
 	// Clear VRAM and OAM
-	// VRAM is 0x800 bytes (nametables + palettes are accessed through mirroring)
-	for (int i = 0; i < 0x800; i++) vram[i] = 0;
+	// 2KB of nametables on the board, the other 2KB is only used for four screen carts
+	for (int i = 0; i < 0x1000; i++) vram[i] = 0;
 	for (int i = 0; i < 256; i++) oam.raw[i] = 0;
+	for (int i = 0; i < 32; i++) palette[i] = 0;
 }
 
 bool PPU::step(int cycles) {
 	dot += cycles;
 	cycle += cycles;
 
-	if (dot < 341) {
-		return false;
+	bool frameDone = false;
+	while (dot >= 341) {
+		if (endLine()) frameDone = true;
 	}
+	return frameDone;
+}
 
-	if (MASKshowSprites() && oam.sprites[0].y <= scanline && oam.sprites[0].y + 8 > scanline && oam.sprites[0].x <= dot) {
-		// now check if the sprite has any pixels in the row
-		// copied from composite sprite rendering
-		
-		int spriteY = oam.sprites[0].y + 1;
+// a line is finished once its dot count reaches 341
+int PPU::dotsToVblank() const {
+	int lines = scanline <= 240 ? 240 - scanline : 240 + 262 - scanline;
+	return lines * 341 + 341 - dot;
+}
 
-		int y = scanline - spriteY;
-	
-		int spriteX = oam.sprites[0].x;
-		int spriteIdx = oam.sprites[0].tileIdx;
-		uint8_t attributes = oam.sprites[0].attr;
+int PPU::dotsToFrameEnd() const {
+	return (261 - scanline) * 341 + 341 - dot;
+}
 
-		bool flipY = (attributes & 0x80) != 0;
+int PPU::dotsToScanlineClock(int count) {
+	int clockDot = scanlineClockDot();
+	if (clockDot < 0 || count <= 0 || !(MASKshowBackground() || MASKshowSprites())) return -1;
 
-		uint8_t highByte, lowByte;
+	// the clock happens when the ppu draws past clockDot on every rendered line
+	int line = scanline;
+	int dots = -dot;
+	if (dot > clockDot) {
+		line = (line + 1) % 262;
+		dots += 341;
+	}
+	while (true) {
+		if ((line < 240 || line == 261) && --count == 0) return dots + clockDot + 1;
+		line = (line + 1) % 262;
+		dots += 341;
+	}
+}
 
-		int row = flipY ? (7 - y) : y;
-		highByte = cart->readChr(CTRLspritePatternTableAddress() | spriteIdx * 16 + row);
-		lowByte  = cart->readChr(CTRLspritePatternTableAddress() | spriteIdx * 16 + row + 8);
+// mmc3 style scanline counters count rises of ppu address line 12 that come
+// after it was low for a while. with one pattern table for the background
+// and the other for sprites that is once a line: when the sprite fetches
+// start (dot 260) or when the fetches for the next line start (dot 324).
+// 8x16 sprites fetch from $1000 at least for the unused slots. with both
+// on the same table it never stays low long enough
+int PPU::scanlineClockDot() {
+	bool backgroundHigh = CTRLbackgroundPatternTableAddress() == 0x1000;
+	bool spritesHigh = CTRLspriteSize() == 16 || CTRLspritePatternTableAddress() == 0x1000;
+	if (spritesHigh && !backgroundHigh) return 260;
+	if (backgroundHigh && !spritesHigh) return 324;
+	return -1;
+}
 
-		if (highByte | lowByte) {
-			// not transparent
-			stat.S = 1;
-		}
-	}
+bool PPU::endLine() {
+	renderTo(341);
 
 	dot -= 341;
-	comp->renderScanline(scanline);
+	if (scanline < 240 && (MASKshowBackground() || MASKshowSprites())) {
+		evaluateSprites(scanline);
+	} else {
+		spriteLine.count = 0;
+		spriteLine.hasSprite0 = false;
+	}
+	// sprite 0 hit comes out of drawing the line, it needs both layers
+	if (comp->renderScanline(scanline)) {
+		stat.S = 1;
+	}
+	memset(bgLine, 0, sizeof(bgLine));
+	renderDot = 0;
 	// std::cout << "scanline: " << scanline << std::endl;
 	scanline++;
 
@@ -87,6 +131,179 @@ bool PPU::step(int cycles) {
 	return false;
 }
 
+void PPU::catchUp() {
+	renderTo(dot < 341 ? dot : 341);
+}
+
+void PPU::renderTo(int targetDot) {
+	if (renderDot >= targetDot) return;
+	bool visible = scanline < 240;
+	if ((!visible && scanline != 261) || !(MASKshowBackground() || MASKshowSprites())) {
+		// nothing moves while rendering is off or outside the rendered lines
+		renderDot = targetDot;
+		return;
+	}
+
+	// chr ram writes and bank switches since the last fetch
+	tiles.sync();
+
+	int clockDot = scanlineClockDot();
+	if (clockDot >= renderDot && clockDot < targetDot && cart) {
+		cart->clockScanline();
+	}
+
+	while (renderDot < targetDot) {
+		int d = renderDot;
+		int next;
+
+		// things that happen on this dot, then find the next dot that does anything
+		if (d >= 1 && d <= 249 && ((d - 1) & 7) == 0) {
+			// tiles 2-33 of this line, coarse x moves on after each
+			fetchTile((d - 1) / 8 + 2);
+			incrementX();
+			next = d + 8 < 256 ? d + 8 : 256;
+		} else if (d == 256) {
+			incrementY();
+			next = 257;
+		} else if (d == 257) {
+			// back to the left edge for the next line
+			v = (v & ~0x041F) | (t & 0x041F);
+			next = scanline == 261 ? 304 : 321;
+		} else if (d == 304 && scanline == 261) {
+			// the pre-render line copies the vertical scroll over from 280 to 304,
+			// only the last copy matters
+			v = (v & ~0x7BE0) | (t & 0x7BE0);
+			next = 321;
+		} else if (d == 321 || d == 329) {
+			// first two tiles of the next line
+			fetchTile((d - 321) / 8);
+			incrementX();
+			next = d + 8;
+		} else if (d == 0) {
+			next = 1;
+		} else if (d < 256) {
+			next = ((d - 1) / 8 + 1) * 8 + 1;
+			if (next > 256) next = 256;
+		} else if (d < 257) {
+			next = 257;
+		} else if (d < 304 && scanline == 261) {
+			next = 304;
+		} else if (d < 321) {
+			next = 321;
+		} else if (d < 329) {
+			next = 329;
+		} else {
+			next = 341;
+		}
+		if (next > targetDot) next = targetDot;
+
+		// pixels for dots d up to next, dot 1 draws x = 0
+		if (visible && MASKshowBackground() && d <= 256) {
+			int start = d > 0 ? d - 1 : 0;
+			int end = (next < 257 ? next : 257) - 1;
+			for (int x = start; x < end; x++) {
+				int pos = x + fineX;
+				const BackgroundTile& tile = bgTiles[pos >> 3];
+				uint8_t color = tile.pixels[pos & 7];
+				bgLine[x] = color ? tile.palette * 4 + color : 0;
+			}
+		}
+
+		renderDot = next;
+	}
+}
+
+void PPU::fetchTile(int index) {
+	uint8_t tileIdx = readNametable(0x2000 | (v & 0x0FFF));
+	// one attribute byte per 4x4 tiles, two bits per 2x2
+	uint8_t attr = readNametable(0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07));
+	int shift = ((v >> 4) & 0x04) | (v & 0x02);
+
+	BackgroundTile& tile = bgTiles[index];
+	memcpy(tile.pixels, tiles.getRow(CTRLbackgroundPatternTableAddress() | tileIdx * 16, (v >> 12) & 0x07, false), 8);
+	tile.palette = (attr >> shift) & 0x03;
+}
+
+void PPU::incrementX() {
+	if ((v & 0x001F) == 31) {
+		// wrap into the horizontally next nametable
+		v &= ~0x001F;
+		v ^= 0x0400;
+	} else {
+		v++;
+	}
+}
+
+void PPU::incrementY() {
+	if ((v & 0x7000) != 0x7000) {
+		v += 0x1000; // fine y
+		return;
+	}
+	v &= ~0x7000;
+	int coarseY = (v & 0x03E0) >> 5;
+	if (coarseY == 29) {
+		// last row, wrap into the vertically next nametable
+		coarseY = 0;
+		v ^= 0x0800;
+	} else if (coarseY == 31) {
+		// rows 30 and 31 are the attribute table, wrap without switching
+		coarseY = 0;
+	} else {
+		coarseY++;
+	}
+	v = (v & ~0x03E0) | (coarseY << 5);
+}
+
+void PPU::evaluateSprites(int line) {
+	int height = CTRLspriteSize();
+	spriteLine.count = 0;
+	spriteLine.hasSprite0 = false;
+
+	for (int s = 0; s < 64; s++) {
+		// sprites show up one line below their y
+		int row = line - (oam.sprites[s].y + 1);
+		if (row < 0 || row >= height) continue;
+
+		if (spriteLine.count == 8) {
+			// the real ppu keeps scanning with a buggy address increment that
+			// gives false positives and negatives, this is the intended flag
+			stat.O = 1;
+			break;
+		}
+
+		uint8_t tileIdx = oam.sprites[s].tileIdx;
+		uint8_t attr = oam.sprites[s].attr;
+		if (attr & 0x80) row = height - 1 - row; // flip vertically
+
+		uint16_t patternAddr;
+		if (height == 16) {
+			// bit 0 picks the pattern table, the top tile is the even one
+			patternAddr = ((tileIdx & 1) ? 0x1000 : 0x0000) | (tileIdx & 0xFE) * 16;
+			if (row >= 8) {
+				patternAddr += 16;
+				row -= 8;
+			}
+		} else {
+			patternAddr = CTRLspritePatternTableAddress() | tileIdx * 16;
+		}
+
+		if (s == 0) spriteLine.hasSprite0 = true;
+		spriteLine.sprites[spriteLine.count++] = {patternAddr, (uint8_t)row, attr, oam.sprites[s].x};
+	}
+}
+
+int PPU::getFrame() {
+	return frame;
+}
+
+int PPU::getScanline() const {
+	return scanline;
+}
+
+int PPU::getDot() const {
+	return dot;
+}
+
 
 // PPU Register Read/Writes
 
@@ -97,7 +314,9 @@ uint8_t PPU::CTRLread() {
 }
 
 void PPU::CTRLwrite(uint8_t value) {
+	catchUp();
 	ctrl.raw = value;
+	t = (t & ~0x0C00) | ((value & 0x03) << 10);
 }
 
 uint16_t PPU::CTRLnametableAddress() {
@@ -141,6 +360,7 @@ uint8_t PPU::MASKread() {
 }
 
 void PPU::MASKwrite(uint8_t value) {
+	catchUp();
 	mask.raw = value;
 }
 
@@ -200,37 +420,37 @@ bool PPU::STATspriteOverflow() {
 
 // PPUSCRL
 void PPU::SCRLwrite(uint8_t value) {
+	catchUp();
 	// Use member w instead of a static local so PPUSTATUS reads
 	// can reset this toggle as hardware requires.
 	if (w) {
-		scrl.x = value;
+		// coarse x into t, fine x takes effect right away
+		t = (t & ~0x001F) | (value >> 3);
+		fineX = value & 0x07;
 	} else {
-		scrl.y = value;
+		// fine and coarse y
+		t = (t & ~0x73E0) | ((value & 0x07) << 12) | ((value & 0xF8) << 2);
 	}
 	w = !w;
 }
 
-PPUSCRL PPU::SCRLget() {
-    return scrl;
-}
-
 // PPUADDR
 void PPU::ADDRwrite(uint8_t value) {
-	// Use member w. First write sets high 6 bits, second write sets low 8 bits.
+	catchUp();
+	// First write sets the high 6 bits of t, the second the low 8 bits and
+	// copies t into v. the same t as $2005, which is why mid frame $2006
+	// writes move the scroll
 	if (w) {
-		addr.high = value & 0x3F;  // Only 6 bits are used
+		t = (t & 0x00FF) | ((value & 0x3F) << 8);
 	} else {
-		addr.low = value;
+		t = (t & 0xFF00) | value;
+		v = t;
 	}
 	w = !w;
 }
 
-PPUADDR PPU::ADDRget() {
-    return addr;
-}
-
 void PPU::ADDRincrement(int inc) {
-	addr.value += inc;
+	v = (v + inc) & 0x7FFF;
 }
 
 // OAMADDR
@@ -263,7 +483,8 @@ void PPU::OAMDMAwrite(uint8_t* values) {
 }
 
 uint8_t PPU::read() {
-	uint16_t a = addr.value & 0x3FFF;
+	catchUp();
+	uint16_t a = v & 0x3FFF;
 	uint8_t result = 0;
 
 	switch (a) {
@@ -286,7 +507,8 @@ uint8_t PPU::read() {
 }
 
 void PPU::write(uint8_t value) {
-	uint16_t a = addr.value & 0x3FFF;
+	catchUp();
+	uint16_t a = v & 0x3FFF;
 
 	switch (a) {
 		case 0x0000 ... 0x1FFF:
@@ -335,6 +557,60 @@ uint8_t PPU::useBuffer(uint8_t value) {
 	return tmp;
 }
 
+void PPU::saveState(StateWriter& state) {
+	state.write(ctrl.raw);
+	state.write(mask.raw);
+	state.write(stat.raw);
+	state.write(oamaddr);
+	state.write(oamdata);
+	state.write(v);
+	state.write(t);
+	state.write(fineX);
+	state.write(w);
+
+	state.write(vram);
+	state.write(oam.raw);
+	state.write(palette);
+	state.write(buffer);
+
+	state.write(cycle);
+	state.write(dot);
+	state.write(scanline);
+	state.write(frame);
+
+	state.write(bgTiles);
+	state.write(bgLine);
+	state.write(renderDot);
+}
+
+void PPU::loadState(StateReader& state) {
+	state.read(ctrl.raw);
+	state.read(mask.raw);
+	state.read(stat.raw);
+	state.read(oamaddr);
+	state.read(oamdata);
+	state.read(v);
+	state.read(t);
+	state.read(fineX);
+	state.read(w);
+
+	state.read(vram);
+	state.read(oam.raw);
+	state.read(palette);
+	state.read(buffer);
+
+	state.read(cycle);
+	state.read(dot);
+	state.read(scanline);
+	state.read(frame);
+
+	state.read(bgTiles);
+	state.read(bgLine);
+	state.read(renderDot);
+	// chr may have changed under the cache too
+	tiles.invalidate();
+}
+
 void PPU::connectComposite(Composite* compRef) {
 	comp = compRef;
 }
@@ -353,8 +629,10 @@ void PPU::disconnectCPU() {
 
 void PPU::connectCart(Cart* cartRef) {
 	cart = cartRef;
+	tiles.connectCart(cartRef);
 }
 
 void PPU::disconnectCart() {
 	cart = nullptr;
+	tiles.disconnectCart();
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "rewind.hpp"
+#include "console.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// delta encoding: a list of (zero run, literal length, literal bytes) tokens
+// with both lengths as little endian uint16. short zero runs stay inside the
+// literal since a new token costs 4 bytes
+static const size_t MAX_RUN = 0xFFFF;
+static const size_t MIN_ZERO_RUN = 4;
+
+
+Rewind::Rewind(size_t bufferBytes, size_t maxFrames) {
+	ring.resize(bufferBytes);
+	entries.resize(maxFrames > 0 ? maxFrames : 1);
+}
+
+void Rewind::clear() {
+	ringHead = 0;
+	ringUsed = 0;
+	entryFirst = 0;
+	entryCount = 0;
+	stateSize = 0;
+}
+
+size_t Rewind::encodeDelta(const uint8_t* older, const uint8_t* newer) {
+	uint8_t* out = delta.data();
+	size_t pos = 0;
+	size_t i = 0;
+	while (i < stateSize) {
+		size_t zeros = 0;
+		while (i + zeros < stateSize && zeros < MAX_RUN && older[i + zeros] == newer[i + zeros]) zeros++;
+		i += zeros;
+
+		// literal runs until the next long stretch of equal bytes
+		size_t start = i;
+		size_t equal = 0;
+		while (i < stateSize && i - start < MAX_RUN) {
+			if (older[i] == newer[i]) {
+				if (++equal >= MIN_ZERO_RUN) break;
+			} else {
+				equal = 0;
+			}
+			i++;
+		}
+		if (equal >= MIN_ZERO_RUN) i -= equal - 1;
+		size_t literal = i - start;
+
+		out[pos++] = zeros & 0xFF;
+		out[pos++] = zeros >> 8;
+		out[pos++] = literal & 0xFF;
+		out[pos++] = literal >> 8;
+		for (size_t j = start; j < i; j++) {
+			out[pos++] = older[j] ^ newer[j];
+		}
+	}
+	return pos;
+}
+
+void Rewind::applyDelta(const Entry& entry, uint8_t* state) {
+	// unwrap the delta into scratch so decoding doesn't have to care about the ring
+	size_t first = std::min((size_t)entry.size, ring.size() - entry.offset);
+	memcpy(delta.data(), ring.data() + entry.offset, first);
+	memcpy(delta.data() + first, ring.data(), entry.size - first);
+
+	const uint8_t* in = delta.data();
+	size_t pos = 0;
+	size_t i = 0;
+	while (pos + 4 <= entry.size) {
+		size_t zeros = in[pos] | (in[pos + 1] << 8);
+		size_t literal = in[pos + 2] | (in[pos + 3] << 8);
+		pos += 4;
+		i += zeros;
+		for (size_t j = 0; j < literal; j++) {
+			state[i++] ^= in[pos++];
+		}
+	}
+}
+
+void Rewind::ringWrite(const uint8_t* data, size_t size) {
+	size_t first = std::min(size, ring.size() - ringHead);
+	memcpy(ring.data() + ringHead, data, first);
+	memcpy(ring.data(), data + first, size - first);
+	ringHead = (ringHead + size) % ring.size();
+	ringUsed += size;
+}
+
+void Rewind::dropOldest() {
+	ringUsed -= entries[entryFirst].size;
+	entryFirst = (entryFirst + 1) % entries.size();
+	entryCount--;
+}
+
+bool Rewind::popNewest() {
+	if (entryCount == 0) return false;
+	const Entry& entry = entries[(entryFirst + entryCount - 1) % entries.size()];
+	applyDelta(entry, current.data());
+	currentFrame = entry.frame;
+	ringHead = (ringHead + ring.size() - entry.size) % ring.size();
+	ringUsed -= entry.size;
+	entryCount--;
+	return true;
+}
+
+void Rewind::push(Console& console) {
+	size_t size = console.stateSize();
+	if (size != stateSize) {
+		// new cart or controller setup, the old history is useless
+		clear();
+		stateSize = size;
+		current.resize(size);
+		next.resize(size);
+		// worst case is a 4 byte token for every 4 byte zero run plus a literal byte
+		delta.resize(2 * size + 16);
+		console.saveState(current.data(), size);
+		currentFrame = console.ppu.getFrame();
+		return;
+	}
+
+	console.saveState(next.data(), size);
+	size_t encoded = encodeDelta(current.data(), next.data());
+
+	if (encoded > ring.size()) {
+		// can't keep anything this big, start over from here
+		entryFirst = 0;
+		entryCount = 0;
+		ringHead = 0;
+		ringUsed = 0;
+	} else {
+		while (entryCount > 0 && (ringUsed + encoded > ring.size() || entryCount == entries.size())) {
+			dropOldest();
+		}
+		entries[(entryFirst + entryCount) % entries.size()] = {ringHead, (uint32_t)encoded, currentFrame};
+		entryCount++;
+		ringWrite(delta.data(), encoded);
+	}
+
+	current.swap(next);
+	currentFrame = console.ppu.getFrame();
+}
+
+bool Rewind::stepBack(Console& console) {
+	if (!popNewest()) return false;
+	return console.loadState(current.data(), stateSize);
+}
+
+bool Rewind::seekFrame(Console& console, uint32_t frame) {
+	if (stateSize == 0) return false;
+	// decode all the way back first, only the last state needs loading
+	while (currentFrame > frame && popNewest());
+	return console.loadState(current.data(), stateSize) && currentFrame <= frame;
+}
+
+size_t Rewind::getFrameCount() const {
+	return entryCount;
+}
+
+size_t Rewind::getMemoryUsed() const {
+	return ringUsed;
+}
+
+uint32_t Rewind::getOldestFrame() const {
+	if (entryCount == 0) return currentFrame;
+	return entries[entryFirst].frame;
+}
@@ -0,0 +1,48 @@
+#include "tilecache.hpp"
+#include "cart.hpp"
+
+TileCache::TileCache() {
+	invalidate();
+}
+
+void TileCache::invalidate() {
+	for (int i = 0; i < TILE_COUNT; i++) valid[i] = false;
+	const uint32_t* versions = cart ? cart->getChrVersions() : nullptr;
+	for (int i = 0; i < PAGE_COUNT; i++) pageVersions[i] = versions ? versions[i] : 0;
+}
+
+void TileCache::sync() {
+	const uint32_t* versions = cart ? cart->getChrVersions() : nullptr;
+	if (!versions) return;
+	for (int page = 0; page < PAGE_COUNT; page++) {
+		if (versions[page] == pageVersions[page]) continue;
+		pageVersions[page] = versions[page];
+		for (int i = 0; i < TILES_PER_PAGE; i++) valid[page * TILES_PER_PAGE + i] = false;
+	}
+}
+
+void TileCache::decode(int tile) {
+	// first 8 bytes are bit 0 of each row, the next 8 are bit 1
+	uint16_t base = tile * 16;
+	for (int row = 0; row < 8; row++) {
+		uint8_t plane0 = cart ? cart->readChr(base + row) : 0;
+		uint8_t plane1 = cart ? cart->readChr(base + row + 8) : 0;
+		for (int x = 0; x < 8; x++) {
+			int bit = 7 - x;
+			uint8_t color = ((plane0 >> bit) & 1) | (((plane1 >> bit) & 1) << 1);
+			pixels[tile][0][row * 8 + x] = color;
+			pixels[tile][1][row * 8 + 7 - x] = color;
+		}
+	}
+	valid[tile] = true;
+}
+
+void TileCache::connectCart(Cart* cartRef) {
+	cart = cartRef;
+	invalidate();
+}
+
+void TileCache::disconnectCart() {
+	cart = nullptr;
+	invalidate();
+}
@@ -0,0 +1,92 @@
+#include "trace.hpp"
+#include "cpu.hpp"
+
+TraceRecorder::~TraceRecorder() {
+	stop();
+}
+
+void TraceRecorder::startRing(size_t capacity) {
+	stop();
+	buffer.assign(capacity > 0 ? capacity : 1, TraceRecord());
+	count = 0;
+	wrapped = false;
+	total = 0;
+}
+
+bool TraceRecorder::startFile(const std::string& path, size_t bufferRecords) {
+	stop();
+	file = fopen(path.c_str(), "wb");
+	if (!file) return false;
+	buffer.assign(bufferRecords > 0 ? bufferRecords : 1, TraceRecord());
+	count = 0;
+	wrapped = false;
+	total = 0;
+	return true;
+}
+
+void TraceRecorder::stop() {
+	if (!file) return;
+	fwrite(buffer.data(), sizeof(TraceRecord), count, file);
+	fclose(file);
+	file = nullptr;
+	// everything is on disk, the buffer is kept as an empty ring
+	count = 0;
+	wrapped = false;
+}
+
+void TraceRecorder::bufferFull() {
+	if (file) {
+		fwrite(buffer.data(), sizeof(TraceRecord), count, file);
+	} else {
+		wrapped = true;
+	}
+	count = 0;
+}
+
+std::vector<TraceRecord> TraceRecorder::getRecords() const {
+	if (file) return {};
+	std::vector<TraceRecord> records;
+	if (wrapped) records.insert(records.end(), buffer.begin() + count, buffer.end());
+	records.insert(records.end(), buffer.begin(), buffer.begin() + count);
+	return records;
+}
+
+uint64_t TraceRecorder::getTotal() const {
+	return total;
+}
+
+int formatTraceRecord(const TraceRecord& entry, char* out, size_t size) {
+	char bytes[9];
+	for (int i = 0; i < 3; i++) {
+		if (i < entry.length) snprintf(bytes + i * 3, 4, i < 2 ? "%02X " : "%02X", entry.bytes[i]);
+		else snprintf(bytes + i * 3, 4, i < 2 ? "   " : "  ");
+	}
+
+	char flags[9];
+	for (int i = 7; i >= 0; i--) {
+		flags[7 - i] = ((entry.p >> i) & 1) ? '1' : '0';
+	}
+	flags[8] = '\0';
+
+	return snprintf(out, size, "%04X %s %-3s a:%02X x:%02X y:%02X p:%s sp:%02X cyc:%llu",
+		entry.pc, bytes, CPU::getMnemonic(entry.bytes[0]), entry.a, entry.x, entry.y,
+		flags, entry.s, (unsigned long long)entry.cycle);
+}
+
+bool formatTraceFile(const std::string& path, FILE* out) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) return false;
+
+	std::vector<TraceRecord> records(1 << 14);
+	char line[128];
+	size_t read;
+	while ((read = fread(records.data(), sizeof(TraceRecord), records.size(), file)) > 0) {
+		for (size_t i = 0; i < read; i++) {
+			formatTraceRecord(records[i], line, sizeof(line));
+			fputs(line, out);
+			fputc('\n', out);
+		}
+	}
+	fclose(file);
+	return true;
+}
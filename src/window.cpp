@@ -1,6 +1,9 @@
 #include "window.hpp"
 #include "ui/font.hpp"
 
+#include <chrono>
+#include <thread>
+
 int Window::StartWindow() {
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
 		std::cout << "Failed to initialize the SDL2 library\n";
@@ -61,34 +64,28 @@ bool Window::pollEvent(SDL_Event* event) {
 }
 
 void Window::updateSurface(double emulationSpeed) {
-	// current time from ctime in milliseconds
-	int64_t currentTime = SDL_GetTicks64();
-
 	// Guard against invalid speed values
 	if (emulationSpeed <= 0.0) emulationSpeed = 1.0;
 
-	// Target frame time in milliseconds for 60 FPS, adjusted by emulation speed.
-	// e.g. emulationSpeed == 1.0 -> ~16.6667 ms, emulationSpeed == 2.0 -> ~8.333 ms
-	double targetFrameTime = (1000.0 / 60.0) / emulationSpeed;
-
-	// If timeAlive is zero (first frame), initialize it to now to avoid large delay
-	if (timeAlive == 0) {
-		timeAlive = currentTime;
-	}
-
-	int64_t timeSinceLastFrame = currentTime - timeAlive;
-
 	// A very large emulationSpeed (used elsewhere as a sentinel) means "don't wait"
 	if (emulationSpeed < 1000.0) {
-		if (timeSinceLastFrame < targetFrameTime) {
-			Uint32 delayMs = (Uint32)ceil(targetFrameTime - timeSinceLastFrame);
-			if (delayMs > 0) SDL_Delay(delayMs);
+		uint64_t frequency = SDL_GetPerformanceFrequency();
+		uint64_t period = (uint64_t)(frequency / (FRAME_RATE * emulationSpeed));
+		uint64_t now = SDL_GetPerformanceCounter();
+
+		// deadlines advance by exactly one period so rounding never adds up.
+		// after a stall (pause, menu, slow frames) start over from now instead
+		// of rushing to catch up
+		if (nextFrameTime == 0 || now > nextFrameTime + 4 * period) {
+			nextFrameTime = now;
+		} else {
+			waitUntil(nextFrameTime);
 		}
+		nextFrameTime += period;
+	} else {
+		nextFrameTime = 0;
 	}
 
-	// Update the last-frame timestamp after any sleeping
-	timeAlive = SDL_GetTicks64();
-
 	// Present the backbuffer to the screen
 	SDL_RenderPresent(renderer);
 	
@@ -96,6 +93,26 @@ void Window::updateSurface(double emulationSpeed) {
 	SDL_RenderClear(renderer);
 }
 
+void Window::shiftFrameDeadline(double ms) {
+	// no deadline yet (or not waiting at all), the next present starts over
+	if (nextFrameTime == 0) return;
+	int64_t ticks = (int64_t)(ms * SDL_GetPerformanceFrequency() / 1000.0);
+	nextFrameTime = (uint64_t)((int64_t)nextFrameTime + ticks);
+}
+
+void Window::waitUntil(uint64_t deadline) {
+	uint64_t frequency = SDL_GetPerformanceFrequency();
+	uint64_t margin = frequency * 2 / 1000;
+	uint64_t now = SDL_GetPerformanceCounter();
+	if (deadline > now + margin) {
+		uint64_t sleepTicks = deadline - now - margin;
+		std::this_thread::sleep_for(std::chrono::microseconds(sleepTicks * 1000000 / frequency));
+	}
+	while (SDL_GetPerformanceCounter() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
 void Window::closeWindow() {
 	closeAudio();
 	if (texture) SDL_DestroyTexture(texture);
@@ -182,15 +199,45 @@ void Window::setLogicalSize(int width, int height) {
 	}
 }
 
-// Audio functions (Unchanged)
-bool Window::initAudio(int frequency, uint16_t format, int channels, int samples) {
+// Audio functions
+
+void Window::audioCallback(void* userdata, Uint8* stream, int len) {
+	Window* self = static_cast<Window*>(userdata);
+	int16_t* out = reinterpret_cast<int16_t*>(stream);
+	size_t count = len / sizeof(int16_t);
+
+	size_t got = self->audioRing.read(out, count);
+	if (got > 0) self->audioLastSample = out[got - 1];
+	if (got < count) {
+		// ran dry, hold the last level instead of dropping to zero so it doesn't click
+		for (size_t i = got; i < count; i++) out[i] = self->audioLastSample;
+		self->audioUnderruns.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool Window::initAudio(int frequency, int targetLatency) {
+	audioTargetFill = (size_t)frequency * targetLatency / 1000;
+	audioMaxFill = audioTargetFill * 2;
+
+	// the device pulls in chunks, keep them at most half the target so a
+	// single callback can't empty the ring
+	int deviceSamples = 256;
+	while ((size_t)deviceSamples * 4 <= audioTargetFill) deviceSamples <<= 1;
+
+	audioRing.init(audioMaxFill + deviceSamples);
+	audioLastSample = 0;
+	audioUnderruns = 0;
+	audioOverruns = 0;
+	audioStarted = false;
+
 	SDL_AudioSpec wanted;
+	SDL_zero(wanted);
 	wanted.freq = frequency;
-	wanted.format = format;
-	wanted.channels = channels;
-	wanted.samples = samples;
-	wanted.callback = nullptr; 
-	wanted.userdata = nullptr;
+	wanted.format = AUDIO_S16SYS;
+	wanted.channels = 1;
+	wanted.samples = deviceSamples;
+	wanted.callback = audioCallback;
+	wanted.userdata = this;
 
 	audio_device = SDL_OpenAudioDevice(nullptr, 0, &wanted, &audio_spec, 0);
 	if (audio_device == 0) {
@@ -198,13 +245,25 @@ bool Window::initAudio(int frequency, uint16_t format, int channels, int samples
 		return false;
 	}
 
-	SDL_PauseAudioDevice(audio_device, 0);
+	// stays paused until queueAudio has built up the target latency
 	return true;
 }
 
-void Window::queueAudio(std::vector<uint8_t>* buffer) {
-	if (audio_device != 0 && buffer != nullptr) {
-		SDL_QueueAudio(audio_device, buffer->data(), buffer->size());
+void Window::queueAudio(const int16_t* samples, size_t count) {
+	if (audio_device == 0 || samples == nullptr) return;
+
+	size_t queued = audioRing.fill();
+	size_t space = queued < audioMaxFill ? audioMaxFill - queued : 0;
+	if (count > space) {
+		// running ahead of the device, drop the end of the frame rather than add latency
+		audioOverruns += count - space;
+		count = space;
+	}
+	audioRing.write(samples, count);
+
+	if (!audioStarted && audioRing.fill() >= audioTargetFill) {
+		audioStarted = true;
+		SDL_PauseAudioDevice(audio_device, 0);
 	}
 }
 
@@ -214,17 +273,25 @@ void Window::pauseAudio(bool pause_on) {
 	}
 }
 
-uint32_t Window::getQueuedAudioSize() const {
+void Window::clearAudioQueue() {
 	if (audio_device != 0) {
-		return SDL_GetQueuedAudioSize(audio_device);
+		// the callback is the only reader, hold it off while the ring empties
+		SDL_LockAudioDevice(audio_device);
+		audioRing.clear();
+		SDL_UnlockAudioDevice(audio_device);
 	}
-	return 0;
 }
 
-void Window::clearAudioQueue() {
-	if (audio_device != 0) {
-		SDL_ClearQueuedAudio(audio_device);
+Window::AudioStats Window::getAudioStats() const {
+	AudioStats stats = {};
+	if (audio_device != 0 && audio_spec.freq > 0) {
+		stats.queued = audioRing.fill();
+		stats.queuedMs = stats.queued * 1000.0 / audio_spec.freq;
+		stats.targetMs = audioTargetFill * 1000.0 / audio_spec.freq;
+		stats.underruns = audioUnderruns.load(std::memory_order_relaxed);
+		stats.overruns = audioOverruns;
 	}
+	return stats;
 }
 
 void Window::closeAudio() {
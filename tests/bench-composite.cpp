@@ -0,0 +1,76 @@
+// scanline compositor benchmark
+// checks the simd priority merge against the scalar one on random lines,
+// then times both merges and a full Composite::renderScanline per scanline
+//
+// usage: bench-composite [rom] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "console.hpp"
+
+int main(int argc, char* argv[]) {
+	const char* romPath = argc > 1 ? argv[1] : "tests/nestest.nes";
+	int iterations = argc > 2 ? atoi(argv[2]) : 200000;
+
+	// about half of each layer transparent so every branch of the merge gets hit
+	uint8_t bg[256], sprite[256], behind[256], simd[256], scalar[256];
+	srand(1);
+	for (int round = 0; round < 1000; round++) {
+		for (int x = 0; x < 256; x++) {
+			bg[x] = rand() & 1 ? 0 : rand() & 0x0F;
+			sprite[x] = rand() & 1 ? 0 : 0x10 | (rand() & 0x0F);
+			behind[x] = rand() & 1 ? 0xFF : 0x00;
+		}
+		Composite::mergeLine(bg, sprite, behind, simd);
+		Composite::mergeLineScalar(bg, sprite, behind, scalar);
+		if (memcmp(simd, scalar, sizeof(simd)) != 0) {
+			fprintf(stderr, "simd merge doesn't match scalar merge\n");
+			return 1;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		Composite::mergeLine(bg, sprite, behind, simd);
+		bg[i & 0xFF] ^= simd[(i + 1) & 0xFF]; // keep the loop from being hoisted
+	}
+	double simdSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		Composite::mergeLineScalar(bg, sprite, behind, scalar);
+		bg[i & 0xFF] ^= scalar[(i + 1) & 0xFF];
+	}
+	double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("merge: simd %.1f ns/line, scalar %.1f ns/line\n",
+		simdSeconds / iterations * 1e9, scalarSeconds / iterations * 1e9);
+
+	Cart cart(romPath);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		fprintf(stderr, "failed to load %s\n", romPath);
+		return 1;
+	}
+
+	std::unique_ptr<Console> console = Console::create(&cart);
+	for (int frame = 0; frame < 60; frame++) {
+		console->stepFrame();
+	}
+
+	int frames = iterations / 240 + 1;
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int line = 0; line < 240; line++) {
+			console->comp.renderScanline(line);
+		}
+	}
+	double renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("renderScanline: %.1f ns/line\n", renderSeconds / (frames * 240.0) * 1e9);
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+// cpu dispatch benchmark
+// runs nestest.nes in automation mode (PC=$C000) over and over with only the
+// bus and cartridge attached and reports emulated instructions per second,
+// once an instruction at a time with clock() and once in batches with run().
+// also checks that both end up in the same place and that breakpoints stop
+// and resume the batch loop, and times the trace recorder
+//
+// usage: bench-cpu [rom] [passes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bus.hpp"
+#include "cart.hpp"
+#include "cpu.hpp"
+#include "trace.hpp"
+
+// nestest finishes its automation run after this many instructions
+static const int NESTEST_INSTRUCTIONS = 8991;
+
+int main(int argc, char* argv[]) {
+	const char* romPath = argc > 1 ? argv[1] : "tests/nestest.nes";
+	int passes = argc > 2 ? atoi(argv[2]) : 2000;
+
+	Cart cart(romPath);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		fprintf(stderr, "failed to load %s\n", romPath);
+		return 1;
+	}
+
+	Bus bus;
+	CPU cpu;
+	cpu.connectBus(&bus);
+	bus.connectCart(&cart);
+
+	// one pass a step at a time to find where nestest ends up
+	bus.clearMem();
+	cpu.powerOn();
+	cpu.setPC(0xC000);
+	long startCycles = cpu.getCycles();
+	for (int i = 0; i < NESTEST_INSTRUCTIONS; i++) {
+		cpu.clock();
+	}
+	long passCycles = cpu.getCycles() - startCycles;
+	uint16_t endPC = cpu.getPC();
+
+	bus.clearMem();
+	cpu.powerOn();
+	cpu.setPC(0xC000);
+	if (cpu.run(passCycles) != CPU::RUN_BUDGET || cpu.getCycles() - startCycles != passCycles || cpu.getPC() != endPC) {
+		fprintf(stderr, "run() doesn't match clock(): pc %04X cycles %ld\n", cpu.getPC(), cpu.getCycles() - startCycles);
+		return 1;
+	}
+
+	// stop in front of the jmp at the start, then carry on past it
+	bus.clearMem();
+	cpu.powerOn();
+	cpu.setPC(0xC000);
+	cpu.addBreakpoint(0xC000);
+	if (cpu.run(passCycles) != CPU::RUN_BREAKPOINT || cpu.getPC() != 0xC000 || cpu.getCycles() != startCycles) {
+		fprintf(stderr, "breakpoint didn't stop at C000\n");
+		return 1;
+	}
+	if (cpu.run(passCycles) != CPU::RUN_BUDGET || cpu.getPC() != endPC) {
+		fprintf(stderr, "run() didn't resume from the breakpoint\n");
+		return 1;
+	}
+	cpu.clearBreakpoints();
+
+	// a traced pass, the first line has to match nestest.log
+	TraceRecorder trace;
+	trace.startRing(NESTEST_INSTRUCTIONS);
+	cpu.setTrace(&trace);
+	bus.clearMem();
+	cpu.powerOn();
+	cpu.setPC(0xC000);
+	auto traceStart = std::chrono::steady_clock::now();
+	cpu.run(passCycles);
+	double traceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - traceStart).count();
+	cpu.setTrace(nullptr);
+
+	std::vector<TraceRecord> records = trace.getRecords();
+	char line[128] = "";
+	if (!records.empty()) formatTraceRecord(records[0], line, sizeof(line));
+	const char* expected = "C000 4C F5 C5 JMP a:00 x:00 y:00 p:00100100 sp:FD cyc:7";
+	if (records.size() != NESTEST_INSTRUCTIONS || strcmp(line, expected)) {
+		fprintf(stderr, "trace doesn't start with \"%s\"\n", expected);
+		return 1;
+	}
+	printf("trace: %.2f M instructions/s\n", NESTEST_INSTRUCTIONS / traceSeconds / 1e6);
+
+	// a recorder left attached while it isn't running (never started, or a
+	// stopped file) has to take the records without writing out of bounds
+	TraceRecorder idle;
+	TraceRecorder stopped;
+	const char* tracePath = "bench-cpu-trace.bin";
+	if (!stopped.startFile(tracePath, 16)) {
+		fprintf(stderr, "can't write %s\n", tracePath);
+		return 1;
+	}
+	stopped.stop();
+	remove(tracePath);
+	for (TraceRecorder* recorder : {&idle, &stopped}) {
+		cpu.setTrace(recorder);
+		bus.clearMem();
+		cpu.powerOn();
+		cpu.setPC(0xC000);
+		cpu.run(passCycles);
+		cpu.setTrace(nullptr);
+		if (recorder->getTotal() != NESTEST_INSTRUCTIONS) {
+			fprintf(stderr, "idle trace recorder saw %llu instructions\n", (unsigned long long)recorder->getTotal());
+			return 1;
+		}
+	}
+
+	long instructions = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; pass++) {
+		bus.clearMem();
+		cpu.powerOn();
+		cpu.setPC(0xC000);
+		for (int i = 0; i < NESTEST_INSTRUCTIONS; i++) {
+			cpu.clock();
+		}
+		instructions += NESTEST_INSTRUCTIONS;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("clock: %ld instructions in %.3f s: %.2f M instructions/s\n",
+		instructions, seconds, instructions / seconds / 1e6);
+
+	start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; pass++) {
+		bus.clearMem();
+		cpu.powerOn();
+		cpu.setPC(0xC000);
+		cpu.run(passCycles);
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("run:   %ld instructions in %.3f s: %.2f M instructions/s\n",
+		instructions, seconds, instructions / seconds / 1e6);
+	return 0;
+}
@@ -0,0 +1,109 @@
+// mapper dispatch benchmark
+// loads the rom as each supported mapper (through a header database entry,
+// nestest's 16KB prg and 8KB chr fit all of them) and compares the ppu's chr and nametable
+// fetches going straight through the mapper's slot tables with the same
+// fetches through the virtual mapper calls. checks both give the same
+// bytes and the same frames, then times raw fetches and whole frames
+//
+// usage: bench-mapper [rom] [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "console.hpp"
+
+struct MapperCase {
+	const char* name;
+	int mapperID;
+};
+
+static const MapperCase CASES[] = {
+	{"NROM", 0},
+	{"MMC1", 1},
+	{"UxROM", 2},
+	{"CNROM", 3},
+	{"MMC3", 4},
+	{"AxROM", 7},
+	{"ColorDreams", 11},
+	{"GxROM", 66},
+};
+
+static const int FETCHES = 1 << 26;
+
+// the pattern of a background tile fetch: two nametable reads, two chr reads
+static double timeFetches(Cart& cart, uint32_t& checksum) {
+	uint32_t sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < FETCHES; i += 4) {
+		sum += cart.mirrorNametable(i & 3);
+		sum += cart.mirrorNametable((i >> 2) & 3);
+		sum += cart.readChr((i * 7) & 0x1FFF);
+		sum += cart.readChr((i * 7 + 8) & 0x1FFF);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	checksum = sum;
+	return seconds / FETCHES * 1e9;
+}
+
+static double timeFrames(Cart& cart, int frames, uint64_t& frameHash) {
+	std::unique_ptr<Console> console = Console::create(&cart);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		console->stepFrame();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	frameHash = console->frameHash();
+	return seconds > 0 ? frames / seconds : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+	const char* romPath = argc > 1 ? argv[1] : "tests/nestest.nes";
+	int frames = argc > 2 ? atoi(argv[2]) : 1200;
+
+	Cart original(romPath);
+	if (original.loadStatus != Cart::LOAD_SUCCESS) {
+		fprintf(stderr, "failed to load %s\n", romPath);
+		return 1;
+	}
+
+	for (const MapperCase& test : CASES) {
+		HeaderDatabase database;
+		HeaderFix fix;
+		fix.mapper = test.mapperID;
+		database.add(original.crc, fix);
+
+		Cart cart(romPath, &database);
+		if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+			fprintf(stderr, "failed to load %s as %s\n", romPath, test.name);
+			return 1;
+		}
+
+		uint32_t directSum, virtualSum;
+		uint64_t directHash, virtualHash;
+		// warm up the rom pages once so neither side pays for the first touch
+		timeFrames(cart, 1, directHash);
+
+		cart.setDirectAccess(true);
+		double directFetch = timeFetches(cart, directSum);
+		double directFps = timeFrames(cart, frames, directHash);
+
+		cart.setDirectAccess(false);
+		double virtualFetch = timeFetches(cart, virtualSum);
+		double virtualFps = timeFrames(cart, frames, virtualHash);
+		cart.setDirectAccess(true);
+
+		if (directSum != virtualSum || directHash != virtualHash) {
+			fprintf(stderr, "%s: direct and virtual fetches disagree\n", test.name);
+			return 1;
+		}
+
+		printf("%-5s fetch: direct %.2f ns, virtual %.2f ns; frames: direct %.1f fps, virtual %.1f fps\n",
+			test.name, directFetch, virtualFetch, directFps, virtualFps);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+// save state benchmark
+// times Console::saveState and Console::loadState on a running rom, checks
+// that a restored console replays the exact same frames and that the rewind
+// buffer brings back the exact state of an earlier frame
+//
+// usage: bench-state [rom] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "console.hpp"
+#include "rewind.hpp"
+
+static uint64_t runAndHash(Console* console, int frames) {
+	for (int frame = 0; frame < frames; frame++) {
+		console->stepFrame();
+	}
+	return console->frameHash();
+}
+
+int main(int argc, char* argv[]) {
+	const char* romPath = argc > 1 ? argv[1] : "tests/nestest.nes";
+	int iterations = argc > 2 ? atoi(argv[2]) : 100000;
+
+	Cart cart(romPath);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		fprintf(stderr, "failed to load %s\n", romPath);
+		return 1;
+	}
+
+	std::unique_ptr<Console> console = Console::create(&cart);
+	runAndHash(console.get(), 60);
+
+	std::vector<uint8_t> state(console->stateSize());
+	if (!console->saveState(state.data(), state.size())) {
+		fprintf(stderr, "saveState failed\n");
+		return 1;
+	}
+
+	// a restored console has to replay the same frames
+	uint64_t expected = runAndHash(console.get(), 60);
+	if (!console->loadState(state.data(), state.size())) {
+		fprintf(stderr, "loadState failed\n");
+		return 1;
+	}
+	uint64_t replayed = runAndHash(console.get(), 60);
+	if (replayed != expected) {
+		fprintf(stderr, "replay mismatch: %016llx != %016llx\n",
+			(unsigned long long)replayed, (unsigned long long)expected);
+		return 1;
+	}
+
+	// a truncated state must be rejected
+	if (console->loadState(state.data(), state.size() - 1)) {
+		fprintf(stderr, "truncated state was accepted\n");
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		console->saveState(state.data(), state.size());
+	}
+	double saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		console->loadState(state.data(), state.size());
+	}
+	double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%zu byte state, save %.2f us, load %.2f us\n",
+		state.size(), saveSeconds / iterations * 1e6, loadSeconds / iterations * 1e6);
+
+	// record ten seconds, then rewind and compare with plain saves.
+	// the small buffer wraps around and drops old frames along the way
+	Rewind rewind;
+	Rewind smallRewind(4 << 10);
+	std::vector<uint8_t> middle(state.size());
+	std::vector<uint8_t> late(state.size());
+	std::vector<uint8_t> rewound(state.size());
+	uint32_t middleFrame = 0;
+	uint32_t lateFrame = 0;
+	double pushSeconds = 0;
+	for (int frame = 0; frame < 600; frame++) {
+		console->controller1.setState(frame & 0xFF);
+		console->stepFrame();
+		start = std::chrono::steady_clock::now();
+		rewind.push(*console);
+		pushSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		smallRewind.push(*console);
+		if (frame == 300) {
+			console->saveState(middle.data(), middle.size());
+			middleFrame = console->ppu.getFrame();
+		} else if (frame == 590) {
+			console->saveState(late.data(), late.size());
+			lateFrame = console->ppu.getFrame();
+		}
+	}
+
+	size_t rewindFrames = rewind.getFrameCount();
+	size_t rewindBytes = rewind.getMemoryUsed();
+
+	if (!smallRewind.seekFrame(*console, lateFrame)) {
+		fprintf(stderr, "small rewind to frame %u failed\n", lateFrame);
+		return 1;
+	}
+	console->saveState(rewound.data(), rewound.size());
+	if (rewound != late) {
+		fprintf(stderr, "small rewind state doesn't match frame %u\n", lateFrame);
+		return 1;
+	}
+
+	if (!rewind.seekFrame(*console, middleFrame)) {
+		fprintf(stderr, "rewind to frame %u failed\n", middleFrame);
+		return 1;
+	}
+	console->saveState(rewound.data(), rewound.size());
+	if (rewound != middle) {
+		fprintf(stderr, "rewound state doesn't match frame %u\n", middleFrame);
+		return 1;
+	}
+
+	printf("rewind: %zu frames in %zu bytes (%.1f bytes/frame), push %.2f us\n",
+		rewindFrames, rewindBytes, rewindFrames ? (double)rewindBytes / rewindFrames : 0.0,
+		pushSeconds / 600 * 1e6);
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+// conformance suite
+// runs nestest in automation mode (PC=$C000) with a trace and compares every
+// instruction with nestest.log: pc, opcode bytes, registers, cpu cycle and
+// the ppu scanline/dot. then runs accuracycoin's full test list, reads the
+// result table out of ram and compares it with the recorded baseline, so a
+// test that used to pass and doesn't anymore fails the build. speed is
+// checked against a (generous) floor as well.
+// prints one JSON line per suite and exits non-zero on any failure
+//
+// usage: test-conformance [--nestest rom log] [--accuracycoin rom baseline]
+//                         [--min-fps N] [--update-baseline]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "console.hpp"
+#include "trace.hpp"
+
+// nestest finishes its automation run after this many instructions
+static const int NESTEST_INSTRUCTIONS = 8991;
+
+// accuracycoin keeps one result byte per test at $0400. 1 is a pass,
+// (error code << 2) | 2 a failure, 0 a test that didn't run
+static const uint16_t ACCURACYCOIN_RESULTS = 0x0400;
+static const int ACCURACYCOIN_TESTS = 0x88;
+// start on the menu runs every test. $0035 is set while that is going on
+// and cleared when the result page comes up
+static const uint16_t ACCURACYCOIN_RUNNING = 0x0035;
+static const int ACCURACYCOIN_START_FRAME = 60;
+static const int ACCURACYCOIN_MAX_FRAMES = 6000;
+static const uint8_t BUTTON_START = 0x08;
+
+// one line of nestest.log, the columns are fixed:
+// C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7
+struct NestestLine {
+	unsigned int pc;
+	unsigned int bytes[3];
+	int length;
+	unsigned int a, x, y, p, s;
+	int scanline, dot;
+	unsigned long cycle;
+};
+
+static bool parseNestestLine(const std::string& line, NestestLine& out) {
+	if (line.size() < 91) return false;
+	if (sscanf(line.c_str(), "%4x", &out.pc) != 1) return false;
+	out.length = 0;
+	for (int i = 0; i < 3; i++) {
+		if (line[6 + i * 3] == ' ') break;
+		if (sscanf(line.c_str() + 6 + i * 3, "%2x", &out.bytes[i]) != 1) return false;
+		out.length++;
+	}
+	return sscanf(line.c_str() + 48, " A:%2x X:%2x Y:%2x P:%2x SP:%2x PPU:%d,%d CYC:%lu",
+		&out.a, &out.x, &out.y, &out.p, &out.s, &out.scanline, &out.dot, &out.cycle) == 8;
+}
+
+static bool matches(const TraceRecord& entry, const NestestLine& expected) {
+	if (entry.pc != expected.pc || entry.length != expected.length) return false;
+	for (int i = 0; i < expected.length; i++) {
+		if (entry.bytes[i] != expected.bytes[i]) return false;
+	}
+	return entry.a == expected.a && entry.x == expected.x && entry.y == expected.y
+		&& entry.p == expected.p && entry.s == expected.s
+		&& entry.scanline == expected.scanline && entry.dot == expected.dot
+		&& entry.cycle == expected.cycle;
+}
+
+static bool runNestest(const char* romPath, const char* logPath) {
+	std::vector<std::string> lines;
+	if (FILE* f = fopen(logPath, "r")) {
+		char buffer[256];
+		while (fgets(buffer, sizeof(buffer), f)) {
+			std::string line = buffer;
+			while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+			lines.push_back(line);
+		}
+		fclose(f);
+	}
+	if (lines.size() < NESTEST_INSTRUCTIONS) {
+		printf("{\"suite\":\"nestest\",\"status\":\"can't read %s\"}\n", logPath);
+		return false;
+	}
+
+	Cart cart(romPath);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		printf("{\"suite\":\"nestest\",\"status\":\"can't load %s\"}\n", romPath);
+		return false;
+	}
+
+	std::unique_ptr<Console> console = Console::create(&cart);
+	// automation mode starts straight from power on
+	console->powerOn();
+	console->cpu.setPC(0xC000);
+	// the log starts after the 7 cycle reset sequence, the ppu has run 21 dots by then
+	console->bus.clock(console->cpu.getCycles() * CPU_CLOCK_DIVIDER);
+
+	TraceRecorder trace;
+	trace.startRing(NESTEST_INSTRUCTIONS);
+	console->cpu.setTrace(&trace);
+	for (int i = 0; i < NESTEST_INSTRUCTIONS; i++) {
+		console->cpu.clock();
+	}
+	console->cpu.setTrace(nullptr);
+	std::vector<TraceRecord> records = trace.getRecords();
+
+	int mismatches = 0;
+	int firstMismatch = -1;
+	for (int i = 0; i < NESTEST_INSTRUCTIONS; i++) {
+		NestestLine expected;
+		if (i < (int)records.size() && parseNestestLine(lines[i], expected) && matches(records[i], expected)) continue;
+		mismatches++;
+		if (firstMismatch < 0) firstMismatch = i;
+	}
+
+	if (firstMismatch >= 0) {
+		char line[160] = "<missing>";
+		if (firstMismatch < (int)records.size()) {
+			const TraceRecord& entry = records[firstMismatch];
+			int length = formatTraceRecord(entry, line, sizeof(line));
+			snprintf(line + length, sizeof(line) - length, " ppu:%d,%d", entry.scanline, entry.dot);
+		}
+		fprintf(stderr, "nestest mismatch at line %d:\n  got: %s\n  log: %s\n",
+			firstMismatch + 1, line, lines[firstMismatch].c_str());
+	}
+
+	// the result codes nestest leaves in $02/$03, 0 when everything passed
+	uint8_t official = console->bus.read(0x0002);
+	uint8_t unofficial = console->bus.read(0x0003);
+
+	printf("{\"suite\":\"nestest\",\"status\":\"%s\",\"instructions\":%d,\"mismatches\":%d,"
+		"\"first_mismatch\":%d,\"result_02\":\"%02x\",\"result_03\":\"%02x\"}\n",
+		mismatches == 0 ? "pass" : "fail", NESTEST_INSTRUCTIONS, mismatches, firstMismatch + 1, official, unofficial);
+
+	return mismatches == 0;
+}
+
+static bool loadBaseline(const char* path, std::vector<uint8_t>& results) {
+	FILE* f = fopen(path, "r");
+	if (!f) return false;
+	unsigned int value;
+	while (fscanf(f, "%x", &value) == 1) {
+		results.push_back(value & 0xFF);
+	}
+	fclose(f);
+	return results.size() == ACCURACYCOIN_TESTS;
+}
+
+static bool saveBaseline(const char* path, const uint8_t* results) {
+	FILE* f = fopen(path, "w");
+	if (!f) return false;
+	for (int i = 0; i < ACCURACYCOIN_TESTS; i++) {
+		fprintf(f, "%02x%c", results[i], (i % 16 == 15 || i == ACCURACYCOIN_TESTS - 1) ? '\n' : ' ');
+	}
+	fclose(f);
+	return true;
+}
+
+static bool runAccuracyCoin(const char* romPath, const char* baselinePath, double minFps, bool update) {
+	Cart cart(romPath);
+	if (cart.loadStatus != Cart::LOAD_SUCCESS) {
+		printf("{\"suite\":\"accuracycoin\",\"status\":\"can't load %s\"}\n", romPath);
+		return false;
+	}
+
+	std::unique_ptr<Console> console = Console::create(&cart);
+
+	int frame = 0;
+	bool started = false;
+	auto start = std::chrono::steady_clock::now();
+	for (; frame < ACCURACYCOIN_MAX_FRAMES; frame++) {
+		bool pressed = frame >= ACCURACYCOIN_START_FRAME && frame < ACCURACYCOIN_START_FRAME + 5;
+		console->controller1.setState(pressed ? BUTTON_START : 0);
+		console->stepFrame();
+
+		bool running = console->bus.read(ACCURACYCOIN_RUNNING) != 0;
+		if (started && !running) break;
+		started |= running;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint64_t instructions = console->cpu.getInstructionCount();
+
+	uint8_t results[ACCURACYCOIN_TESTS];
+	for (int i = 0; i < ACCURACYCOIN_TESTS; i++) {
+		results[i] = console->bus.read(ACCURACYCOIN_RESULTS + i);
+	}
+
+	int passed = 0, failed = 0;
+	for (int i = 0; i < ACCURACYCOIN_TESTS; i++) {
+		if (results[i] == 1) passed++;
+		else if ((results[i] & 3) == 2) failed++;
+	}
+
+	bool ok = true;
+	int regressions = 0, improvements = 0;
+	std::vector<uint8_t> baseline;
+	if (update) {
+		if (!saveBaseline(baselinePath, results)) {
+			fprintf(stderr, "can't write %s\n", baselinePath);
+			ok = false;
+		}
+	} else if (!loadBaseline(baselinePath, baseline)) {
+		fprintf(stderr, "can't read %s\n", baselinePath);
+		ok = false;
+	} else {
+		for (int i = 0; i < ACCURACYCOIN_TESTS; i++) {
+			if (baseline[i] == 1 && results[i] != 1) {
+				regressions++;
+				fprintf(stderr, "accuracycoin test $%02x regressed: %02x\n", i, results[i]);
+			} else if (baseline[i] != 1 && results[i] == 1) {
+				improvements++;
+			}
+		}
+		if (improvements) {
+			fprintf(stderr, "accuracycoin: %d more tests pass, run with --update-baseline to keep them\n", improvements);
+		}
+		ok = regressions == 0;
+	}
+
+	bool finished = frame < ACCURACYCOIN_MAX_FRAMES;
+	int frames = finished ? frame + 1 : frame;
+	if (!finished) fprintf(stderr, "accuracycoin didn't finish within %d frames\n", ACCURACYCOIN_MAX_FRAMES);
+	double fps = seconds > 0 ? frames / seconds : 0.0;
+	bool fast = fps >= minFps;
+	if (!fast) fprintf(stderr, "accuracycoin ran at %.1f fps, below the %.1f floor\n", fps, minFps);
+
+	printf("{\"suite\":\"accuracycoin\",\"status\":\"%s\",\"passed\":%d,\"failed\":%d,\"regressions\":%d,"
+		"\"improvements\":%d,\"frames\":%d,\"seconds\":%.6f,\"fps\":%.1f,\"instructions_per_second\":%.0f}\n",
+		ok && finished && fast ? "pass" : "fail", passed, failed, regressions, improvements, frames,
+		seconds, fps, seconds > 0 ? instructions / seconds : 0.0);
+
+	return ok && finished && fast;
+}
+
+int main(int argc, char* argv[]) {
+	const char* nestestRom = "tests/nestest.nes";
+	const char* nestestLog = "tests/nestest.log";
+	const char* accuracyRom = "tests/accuracycoin.nes";
+	const char* accuracyBaseline = "tests/accuracycoin-results.txt";
+	double minFps = 0;
+	bool update = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--nestest") && i + 2 < argc) {
+			nestestRom = argv[++i];
+			nestestLog = argv[++i];
+		} else if (!strcmp(argv[i], "--accuracycoin") && i + 2 < argc) {
+			accuracyRom = argv[++i];
+			accuracyBaseline = argv[++i];
+		} else if (!strcmp(argv[i], "--min-fps") && i + 1 < argc) {
+			minFps = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--update-baseline")) {
+			update = true;
+		} else {
+			fprintf(stderr, "usage: %s [--nestest rom log] [--accuracycoin rom baseline] [--min-fps N] [--update-baseline]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	bool ok = runNestest(nestestRom, nestestLog);
+	fflush(stdout);
+	ok &= runAccuracyCoin(accuracyRom, accuracyBaseline, minFps, update);
+	return ok ? 0 : 1;
+}